@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace platformer2d {
+
+// Replaces the file at path with contents so readers only ever see the old
+// file or the complete new one. The contents go to path + ".tmp", are synced
+// to disk and then renamed over path, so a crash part way through leaves the
+// old file intact. Files other processes have memory mapped stay valid too.
+// Returns false if anything failed, the old file is untouched then.
+bool writeFileAtomic(const std::string& path, std::string_view contents);
+
+}  // namespace platformer2d
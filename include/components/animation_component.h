@@ -1,38 +1,27 @@
 #pragma once
 
+#include <cstdint>
+
 #include "component.h"
+#include "managers/animation_library.h"
 
 namespace platformer2d {
 
-enum class AnimationState {
-  kIdle,
-  kRunning,
-};
-
-class AnimationComponent : public Component {
- public:
-  AnimationComponent(const std::string& tag, const float scale = 1.0f);
+// Which clip an entity shows is decided by its state machine, the component
+// only holds the machine, the current state and the playback position
+struct AnimationComponent : Component {
+  AnimationComponent(const std::string& tag,
+                     AnimationStateMachineId state_machine,
+                     AnimationStateIndex initial_state,
+                     const float scale = 1.0f);
 
-  // Getters
-  std::string getCurrentTextureName() const;
-  int8_t getCurrentNumFrames() const;
-  float getCurrentAnimationFPS() const;
-
-  // Setters
-  void setStateToTextureName(AnimationState state,
-                             const std::string& texture_name);
-  void setStateToAnimationFPS(AnimationState state, float animation_fps);
-  void setStateToNumFrames(AnimationState state, int8_t num_frames);
-
-  // Public Data
-  AnimationState current_state = AnimationState::kIdle;
+  AnimationStateMachineId state_machine;
+  AnimationStateIndex current_state;
   float scale{1.0f};
-  int8_t current_frame{0};
-
- private:
-  std::unordered_map<AnimationState, std::string> state_to_texture_name_map;
-  std::unordered_map<AnimationState, float> state_to_animation_fps;
-  std::unordered_map<AnimationState, int8_t> state_to_num_frames_map;
+  // Playback position in playing_clip
+  AnimationClipId playing_clip{kInvalidAnimationClip};
+  uint16_t current_frame{0};
+  float frame_time{0.0f};
 };
 
-}  // namespace platformer2d
\ No newline at end of file
+}  // namespace platformer2d
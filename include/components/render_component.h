@@ -1,12 +1,13 @@
 #pragma once
 
 #include "component.h"
+#include "managers/texture_handle.h"
 
 namespace platformer2d {
 
 struct RenderComponent : Component {
-  RenderComponent(const std::string& tag, const std::string& texture_name);
-  std::string texture_name;
+  RenderComponent(const std::string& tag, TextureHandle texture);
+  TextureHandle texture;
 };
 
 }  // namespace platformer2d
@@ -4,6 +4,7 @@ namespace platformer2d {
 
 // Global constants
 constexpr int kTargetFPS{60};
+constexpr float kFixedTimestep{1.0f / kTargetFPS};
 constexpr float kGravity{9.8f};
 constexpr int kScreenWidth{800};
 constexpr int kScreenHeight{450};
@@ -3,11 +3,25 @@
 #include <cstdlib>   // For std::abort
 #include <iostream>  // for std::cerr
 
+#include "logging/logger.h"
+
 namespace platformer2d {
 
+// Lowest log level compiled in: 0 debug, 1 info, 2 warning, 3 error. Lines
+// below it cost nothing, not even evaluating the message. Debug builds keep
+// everything, Release only warnings and errors.
+#ifndef PLATFORMER2D_LOG_LEVEL
+#ifndef NDEBUG
+#define PLATFORMER2D_LOG_LEVEL 0
+#else
+#define PLATFORMER2D_LOG_LEVEL 2
+#endif
+#endif
+
 #define CHECK(condition, errstring)                                    \
   do {                                                                 \
     if (!(condition)) {                                                \
+      ::platformer2d::Logger::get().flush();                           \
       std::cerr << "Check failed: " << errstring << " in " << __FILE__ \
                 << " at line " << __LINE__ << std::endl;               \
       std::abort();                                                    \
@@ -22,18 +36,47 @@ namespace platformer2d {
 
 #define PANIC(err_message)                                           \
   do {                                                               \
+    ::platformer2d::Logger::get().flush();                           \
     std::cerr << "PANIC: " << err_message << " in file " << __FILE__ \
               << " at line " << __LINE__ << std::endl;               \
     std::abort();                                                    \
   } while (false)
 
-#ifndef NDEBUG
-#define DLOG(message)                               \
-  do {                                              \
-    std::cout << "DEBUG: " << message << std::endl; \
+// Hands the line to the background writer, see Logger
+#define PLATFORMER2D_LOG(level, message)                              \
+  do {                                                                \
+    ::platformer2d::Logger& platformer2d_logger =                     \
+        ::platformer2d::Logger::get();                                \
+    platformer2d_logger.beginLine() << message;                       \
+    platformer2d_logger.endLine(level);                               \
   } while (false)
+
+#if PLATFORMER2D_LOG_LEVEL <= 0
+#define DLOG(message) \
+  PLATFORMER2D_LOG(::platformer2d::LogLevel::kDebug, message)
 #else
 #define DLOG(message) ((void)0)
 #endif
 
+#if PLATFORMER2D_LOG_LEVEL <= 1
+#define LOG_INFO(message) \
+  PLATFORMER2D_LOG(::platformer2d::LogLevel::kInfo, message)
+#else
+#define LOG_INFO(message) ((void)0)
+#endif
+
+#if PLATFORMER2D_LOG_LEVEL <= 2
+#define LOG_WARNING(message) \
+  PLATFORMER2D_LOG(::platformer2d::LogLevel::kWarning, message)
+#else
+#define LOG_WARNING(message) ((void)0)
+#endif
+
+#if PLATFORMER2D_LOG_LEVEL <= 3
+#define LOG_ERROR(message) \
+  PLATFORMER2D_LOG(::platformer2d::LogLevel::kError, message)
+#else
+#define LOG_ERROR(message) ((void)0)
+#endif
+
 }  // namespace platformer2d
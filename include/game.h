@@ -1,13 +1,45 @@
 #pragma once
 
-#include "scenes/scene.h"
+#include <chrono>
 #include <memory>
+#include <string>
+
+#include "managers/animation_library.h"
+#include "managers/file_watcher.h"
+#include "metrics/metrics_registry.h"
+#include "render/render_backend.h"
+#include "render/render_command_list.h"
+#include "scenes/loading_scene.h"
+#include "scenes/scene.h"
 
 namespace platformer2d {
 
+enum class GameMode {
+  kWindowed,  // Normal play with a raylib window
+  kHeadless,  // No window or GPU, input is fed in through setInput
+  kThreaded,  // Window on the main thread, update called from another thread
+};
+
+// Everything the game records each frame, registered with a MetricsRegistry
+// up front so recording is direct. Times are in nanoseconds.
+struct FrameMetrics {
+  explicit FrameMetrics(MetricsRegistry& registry);
+
+  Histogram& frame_ns;   // Between the starts of two updates
+  Histogram& update_ns;  // Game::update
+  Histogram& draw_ns;    // Building the frame's command list
+  Histogram& submit_ns;  // Handing it to the backend, not in threaded mode
+  Counter& ticks;
+  Gauge& entities;
+  Gauge& colliders;
+  Gauge& collision_pairs;
+  Gauge& textures;
+  Gauge& texture_bytes;
+};
+
 class Game {
  public:
-  Game();
+  explicit Game(GameMode mode = GameMode::kWindowed);
   ~Game();
 
   // Delete copy constructors
@@ -19,15 +51,70 @@ class Game {
   Game& operator=(Game&& other) = delete;
 
   // Public methods
-  void update();
-  void draw() const;
+  // delta_time is the simulated time in seconds since the last update
+  void update(float delta_time);
+  // Build the frame and submit it to the render backend
+  void draw();
+
+  // The two halves of draw(). buildFrame only reads simulation state and
+  // submitFrame only touches the backend, so in threaded mode they can run
+  // on different threads.
+  void buildFrame(RenderCommandList& commands) const;
+  void submitFrame(const RenderCommandList& commands);
+
+  // Size the window should be for the current scene
+  int getWindowWidth() const { return window_width_; }
+
+  int getWindowHeight() const { return window_height_; }
+
+  GameMode getMode() const { return mode_; }
+
+  InputManager& getInputManager() { return input_manager_; }
+
+  // Cap on resident texture memory, 0 for no limit. Threaded mode keeps every
+  // texture resident so ignores it.
+  void setTextureBudget(size_t bytes);
+  const TextureStats& getTextureStats() const {
+    return asset_manager_.getStats();
+  }
+
+  // Replace the backend the recorded frame is submitted to
+  void setRenderBackend(std::unique_ptr<RenderBackend> render_backend);
+
+  // Write the metrics as CSV every kMetricsWindowFrames frames. Returns false
+  // if the file could not be opened.
+  bool openMetricsDump(const std::string& path) {
+    return metrics_.openDump(path);
+  }
+  const MetricsRegistry& getMetrics() const { return metrics_; }
 
  private:
+  GameMode mode_;
   InputManager input_manager_;
   AssetManager asset_manager_;
+  AnimationLibrary animation_library_;
+  FileWatcher file_watcher_;
   std::unique_ptr<Scene> current_scene_;
+  LoadingScene loading_scene_;
+  RenderCommandList render_commands_;
+  std::unique_ptr<RenderBackend> render_backend_;
+  int window_width_;
+  int window_height_;
+  MetricsRegistry metrics_;
+  FrameMetrics frame_metrics_;
+  std::chrono::steady_clock::time_point last_update_start_;
+  // Set by setCurrentScene until the scene's first batch of textures is in,
+  // only that batch gets the loading screen
+  bool loading_new_scene_{false};
+#ifdef PLATFORMER2D_PROFILE
+  bool show_profiler_{false};
+#endif
 
   void handleInput();
+  void recordFrameMetrics(std::chrono::steady_clock::time_point start);
+  void reloadChangedFiles();
+  void startLevel();
+  bool isShowingLoadingScreen() const;
   void setCurrentScene(std::unique_ptr<Scene> new_scene);
 };
 
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+#include "constants.h"
+#include "game.h"
+#include "managers/input_recording.h"
+#include "managers/input_script.h"
+
+namespace platformer2d {
+
+// Run the game in its window until the window is closed
+void runWindowed(Game& game);
+
+struct ThreadedOptions {
+  InputRecording* record_input{nullptr};  // Every tick's input is appended
+  // Played back instead of the live input, which takes over once it ends
+  const InputRecording* replay_input{nullptr};
+  bool fast_forward{false};  // Don't wait between ticks while replaying
+};
+
+// Like runWindowed but the simulation runs on its own thread at a fixed
+// timestep and publishes each built frame through a lock free triple buffer.
+// The calling (main) thread polls input, forwards it to the simulation and
+// draws whichever frame is newest, so a slow tick does not delay
+// presentation and a slow present does not delay the simulation.
+void runThreaded(Game& game, const ThreadedOptions& options = {});
+
+struct HeadlessOptions {
+  uint64_t ticks{kTargetFPS * 60};  // Number of fixed steps to simulate
+  float timestep{kFixedTimestep};
+  const InputScript* input_script{nullptr};  // nullptr means no input
+  // Takes the place of input_script, ticks and timestep should match it
+  const InputRecording* replay_input{nullptr};
+  InputRecording* record_input{nullptr};  // Every tick's input is appended
+  bool draw{true};  // Also build (and submit) the render list every tick
+};
+
+struct HeadlessReport {
+  uint64_t ticks{0};
+  double simulated_seconds{0};
+  double wall_seconds{0};
+};
+
+// Step a headless game as fast as possible with a fixed timestep
+HeadlessReport runHeadless(Game& game, const HeadlessOptions& options);
+
+}  // namespace platformer2d
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "level/chunk_window.h"
+#include "level/level_file.h"
+#include "managers/asset_manager.h"
+#include "managers/texture_handle.h"
+#include "mapped_file.h"
+
+namespace platformer2d {
+
+constexpr char kLevelBakedPath[]{"assets/levels/level_editor.baked"};
+
+// Tiles with this texture move (they get a MovementComponent) so each stays
+// its own entity instead of being merged into the static colliders
+constexpr char kMovingTileTexture[]{"tile_winter_ice"};
+
+// A baked level holds everything LevelScene derives from a level up front:
+// the static tiles' colliders merged into as few rectangles as possible,
+// draw lists grouped by chunk, and texture handles already resolved. Built
+// offline by tools/level_bake.cpp (level_bake build target) and loaded by
+// mapping the file. Only the chunks around the player get entities for
+// their merged colliders and only the chunks in view are drawn.
+//
+// Layout, all offsets from the start of the file: header, texture table,
+// chunks, sprites, colliders, moving tiles, then the string table holding
+// the texture names.
+struct BakedLevelHeader {
+  char magic[4];  // "P2LK"
+  uint32_t version;
+  uint32_t num_textures;
+  uint32_t textures_offset;
+  uint32_t num_chunks;
+  uint32_t chunks_offset;
+  uint32_t num_sprites;
+  uint32_t sprites_offset;
+  uint32_t num_colliders;
+  uint32_t colliders_offset;
+  uint32_t num_moving_tiles;
+  uint32_t moving_tiles_offset;
+  uint32_t strings_offset;
+  uint32_t strings_size;
+  // Where the level's grid sits in the world, to find the chunk of a point
+  uint32_t width;  // In tiles
+  uint32_t height;
+  float origin_x;
+  float origin_y;
+  float tile_size;
+};
+static_assert(sizeof(BakedLevelHeader) == 76);
+
+// Handles depend on the order textures are registered in, so each one is
+// stored with its name and checked against the running AssetManager
+struct BakedTexture {
+  LevelFileString name;
+  TextureHandle handle;
+  uint16_t padding;
+};
+
+// The static sprites and colliders of one kLevelChunkSize square chunk, x
+// and y in chunks. Colliders never cross a chunk edge. Chunks with neither
+// are left out.
+struct BakedChunk {
+  int32_t x;
+  int32_t y;
+  uint32_t first_sprite;
+  uint32_t num_sprites;
+  uint32_t first_collider;
+  uint32_t num_colliders;
+};
+
+struct BakedSprite {
+  float x;
+  float y;
+  TextureHandle texture;
+  uint16_t padding;
+};
+
+struct BakedCollider {
+  float x;
+  float y;
+  float width;
+  float height;
+};
+
+struct BakedMovingTile {
+  uint32_t grid_x;
+  uint32_t grid_y;
+  float x;
+  float y;
+  TextureHandle texture;
+  uint16_t padding;
+};
+
+// Bakes the level against the textures registered in assets. Returns false
+// if a texture is unknown or the file could not be written.
+bool bakeLevel(const LevelData& level, const AssetManager& assets,
+               const std::string& path);
+
+// A baked level memory mapped and read in place
+class BakedLevel {
+ public:
+  BakedLevel() = default;
+
+  // Returns false if the file is missing or not a valid baked level
+  bool open(const std::string& path);
+  void close();
+  bool isOpen() const { return file_.isOpen(); }
+
+  // Whether every baked handle still names the same texture in assets. If
+  // not the level was baked against a different manifest and is stale.
+  bool matches(const AssetManager& assets) const;
+
+  // The chunk holding the point, which may be outside the level
+  LevelChunkCoord getChunkCoord(float x, float y) const;
+  // Null if the chunk has no sprites or colliders
+  const BakedChunk* findChunk(const LevelChunkCoord& coord) const;
+  int32_t getNumChunksX() const;
+  int32_t getNumChunksY() const;
+
+  std::span<const BakedTexture> getTextures() const { return textures_; }
+  std::span<const BakedChunk> getChunks() const { return chunks_; }
+  std::span<const BakedSprite> getSprites() const { return sprites_; }
+  std::span<const BakedCollider> getColliders() const { return colliders_; }
+  std::span<const BakedMovingTile> getMovingTiles() const {
+    return moving_tiles_;
+  }
+  std::string_view getString(const LevelFileString& string) const {
+    return std::string_view{strings_ + string.offset, string.length};
+  }
+
+ private:
+  MappedFile file_;
+  BakedLevelHeader header_{};
+  // Index into chunks_ by LevelChunkCoord key
+  std::unordered_map<uint64_t, uint32_t> chunk_index_;
+  std::span<const BakedTexture> textures_;
+  std::span<const BakedChunk> chunks_;
+  std::span<const BakedSprite> sprites_;
+  std::span<const BakedCollider> colliders_;
+  std::span<const BakedMovingTile> moving_tiles_;
+  const char* strings_{nullptr};
+};
+
+}  // namespace platformer2d
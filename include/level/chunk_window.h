@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace platformer2d {
+
+// Chunks within kChunkLoadRadius of the focus chunk are loaded and they are
+// only dropped once further than kChunkUnloadRadius, so walking back and
+// forth over a chunk edge doesn't thrash.
+constexpr int kChunkLoadRadius{1};
+constexpr int kChunkUnloadRadius{2};
+
+struct LevelChunkCoord {
+  int32_t x;
+  int32_t y;
+
+  bool operator==(const LevelChunkCoord&) const = default;
+  uint64_t getKey() const {
+    return (uint64_t)(uint32_t)x << 32 | (uint32_t)y;
+  }
+  static LevelChunkCoord fromKey(uint64_t key) {
+    return LevelChunkCoord{(int32_t)(uint32_t)(key >> 32),
+                           (int32_t)(uint32_t)key};
+  }
+};
+
+// The set of chunks kept loaded around a moving focus, shared by everything
+// that streams a level in chunks
+class ChunkWindow {
+ public:
+  ChunkWindow() = default;
+
+  // Forgets every chunk and sets the level's size in chunks
+  void reset(int32_t num_chunks_x, int32_t num_chunks_y);
+  // Chunks of the level that came within kChunkLoadRadius of the focus are
+  // added to loaded, ones now further than kChunkUnloadRadius are forgotten
+  // and added to unloaded
+  void update(const LevelChunkCoord& focus,
+              std::vector<LevelChunkCoord>& loaded,
+              std::vector<LevelChunkCoord>& unloaded);
+  bool contains(const LevelChunkCoord& coord) const {
+    return chunks_.contains(coord.getKey());
+  }
+  // Keys of the loaded chunks, see LevelChunkCoord::fromKey
+  const std::unordered_set<uint64_t>& getChunks() const { return chunks_; }
+
+ private:
+  bool isInLevel(const LevelChunkCoord& coord) const;
+
+  int32_t num_chunks_x_{0};
+  int32_t num_chunks_y_{0};
+  std::unordered_set<uint64_t> chunks_;
+};
+
+}  // namespace platformer2d
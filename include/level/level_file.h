@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "constants.h"
+#include "mapped_file.h"
+#include "nlohmann/json.hpp"
+
+namespace platformer2d {
+
+constexpr char kLevelJsonPath[]{"assets/levels/level_editor.json"};
+constexpr char kLevelBinaryPath[]{"assets/levels/level_editor.p2dl"};
+
+// Grid cells hold a palette index + 1, 0 is an empty cell
+using LevelTileId = uint16_t;
+constexpr LevelTileId kEmptyLevelTile{0};
+
+// Levels are streamed, saved and redrawn in square chunks of this many tiles
+constexpr uint32_t kLevelChunkSize{16};
+
+// Binary level layout, all offsets from the start of the file:
+// header, palette entries, entity records, the row major tile grid, then the
+// string table the palette and entities point into.
+struct LevelFileHeader {
+  char magic[4];  // "P2DL"
+  uint32_t version;
+  uint32_t width;  // In tiles
+  uint32_t height;
+  float origin_x;  // Position of tile (0, 0)
+  float origin_y;
+  float tile_size;
+  uint32_t palette_size;
+  uint32_t palette_offset;
+  uint32_t num_entities;
+  uint32_t entities_offset;
+  uint32_t tiles_offset;
+  uint32_t strings_offset;
+  uint32_t strings_size;
+};
+static_assert(sizeof(LevelFileHeader) == 56);
+
+struct LevelFileString {
+  uint32_t offset;  // Into the string table
+  uint32_t length;
+};
+
+struct LevelFileEntity {
+  LevelFileString name;
+  float x;
+  float y;
+};
+
+struct LevelEntity {
+  std::string name;
+  float x;
+  float y;
+};
+
+// A level held in memory, used for editing and for converting between the
+// json and binary formats.
+//
+// Json format:
+// {"tile_map": {"tiles": [[{"texture_name": "", "x": 0, "y": 0}, ...], ...]},
+//  "entities": [{"name": "...", "x": 0, "y": 0}, ...]}   <- optional
+struct LevelData {
+  uint32_t width{0};
+  uint32_t height{0};
+  float origin_x{0};
+  float origin_y{0};
+  float tile_size{kTileSize};
+  std::vector<std::string> palette;  // Texture names
+  std::vector<LevelTileId> tiles;    // width * height, row major
+  std::vector<LevelEntity> entities;
+
+  LevelTileId getTile(uint32_t x, uint32_t y) const {
+    return tiles[y * width + x];
+  }
+  // The id for a texture name, added to the palette if new
+  LevelTileId getTileId(const std::string& texture_name);
+
+  // Streams the json in, returns false if it is malformed or not a level
+  static bool fromJson(std::istream& input, LevelData& level);
+  nlohmann::json toJson() const;
+  // The pieces of toJson, so a row can be serialised on its own
+  nlohmann::json rowToJson(uint32_t y) const;
+  nlohmann::json entitiesToJson() const;
+  // The binary file's bytes
+  std::string toBinary() const;
+  // Replaces the file atomically, returns false if it could not be written
+  bool saveBinary(const std::string& path) const;
+};
+
+// A binary level memory mapped and read in place. Opening validates the
+// tables and tile ids but nothing is parsed or copied.
+class LevelFile {
+ public:
+  LevelFile() = default;
+
+  // Returns false if the file is missing or not a valid level
+  bool open(const std::string& path);
+  void close();
+  bool isOpen() const { return file_.isOpen(); }
+
+  const LevelFileHeader& getHeader() const { return header_; }
+  uint32_t getWidth() const { return header_.width; }
+  uint32_t getHeight() const { return header_.height; }
+  std::span<const LevelTileId> getTiles() const { return tiles_; }
+  LevelTileId getTile(uint32_t x, uint32_t y) const {
+    return tiles_[y * header_.width + x];
+  }
+  // Texture name for a non empty tile id
+  std::string_view getTextureName(LevelTileId tile) const {
+    return getString(palette_[tile - 1]);
+  }
+  // Names of every texture the level uses, indexed by tile id - 1
+  std::span<const LevelFileString> getPalette() const { return palette_; }
+  std::span<const LevelFileEntity> getEntities() const { return entities_; }
+  std::string_view getString(const LevelFileString& string) const {
+    return std::string_view{strings_ + string.offset, string.length};
+  }
+
+  LevelData toData() const;
+
+ private:
+  MappedFile file_;
+  LevelFileHeader header_{};
+  std::span<const LevelFileString> palette_;
+  std::span<const LevelFileEntity> entities_;
+  std::span<const LevelTileId> tiles_;
+  const char* strings_{nullptr};
+};
+
+// Whether the binary level exists and is at least as new as the json one, so
+// hand edits to the json are never shadowed by a stale binary
+bool isBinaryLevelCurrent(const std::string& json_path,
+                          const std::string& binary_path);
+
+}  // namespace platformer2d
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string_view>
+
+#include "level/level_file.h"
+
+namespace platformer2d {
+
+// One cell of a json level's tile grid, handed out as soon as it is parsed
+struct LevelJsonCell {
+  uint32_t grid_x;
+  uint32_t grid_y;
+  // Empty for an empty cell. Only valid during the callback.
+  std::string_view texture_name;
+  float x;
+  float y;
+};
+
+using LevelCellCallback = std::function<void(const LevelJsonCell&)>;
+using LevelEntityCallback = std::function<void(const LevelEntity&)>;
+
+// Streams a json level (see LevelData for the format) through the callbacks
+// using nlohmann's SAX interface, so the document is never held in memory.
+// Every cell is reported, empty or not, row by row. Unknown keys are
+// skipped. Returns false if the json is malformed or has no tile grid, the
+// callbacks may already have seen part of the level by then.
+bool readLevelJson(std::istream& input, const LevelCellCallback& on_cell,
+                   const LevelEntityCallback& on_entity = nullptr);
+
+}  // namespace platformer2d
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "level/chunk_window.h"
+#include "level/level_file.h"
+
+namespace platformer2d {
+
+struct LevelChunkTile {
+  uint32_t grid_x;
+  uint32_t grid_y;
+  // Points into the level file, valid until it is closed or reopened
+  std::string_view texture_name;
+  float x;
+  float y;
+};
+
+// The non empty tiles of one chunk
+struct LevelChunk {
+  LevelChunkCoord coord;
+  std::vector<LevelChunkTile> tiles;
+};
+
+// Streams a binary level in chunks around a focus point (the player). The
+// level stays memory mapped and a background thread reads the chunks the
+// focus moves towards, so pages are faulted in off the main thread. The main
+// thread only ever picks up finished chunks.
+class LevelStreamer {
+ public:
+  LevelStreamer() = default;
+  ~LevelStreamer();
+
+  LevelStreamer(const LevelStreamer&) = delete;
+  LevelStreamer& operator=(const LevelStreamer&) = delete;
+
+  // Returns false if the file is missing or not a valid level. Reopening
+  // forgets every chunk, pending or loaded.
+  bool open(const std::string& path);
+  void close();
+  bool isOpen() const { return level_.isOpen(); }
+
+  // Reads the chunks around the focus on the calling thread, for when the
+  // level first appears and nothing may be missing
+  std::vector<LevelChunk> loadAround(float focus_x, float focus_y);
+  // Queues chunks the focus moved near for the background thread and
+  // returns the loaded chunks it has moved away from, which are forgotten
+  void update(float focus_x, float focus_y,
+              std::vector<LevelChunkCoord>& unloaded);
+  // A chunk the background thread finished, false if none are ready
+  bool popLoadedChunk(LevelChunk& chunk);
+
+  // Every texture the level uses, so they can be loaded before any chunk
+  // needs them. Point into the level file like the chunks' names.
+  std::vector<std::string_view> getTextureNames() const;
+  // Every tile of one texture across the whole level, read on the calling
+  // thread. For tiles that move and so can't belong to a chunk.
+  std::vector<LevelChunkTile> findTiles(std::string_view texture_name) const;
+
+ private:
+  LevelChunkCoord getChunkCoord(float x, float y) const;
+  LevelChunk readChunk(const LevelChunkCoord& coord) const;
+  void streamWorker();
+
+  LevelFile level_;
+  // Requested or loaded chunks. Main thread only.
+  ChunkWindow wanted_;
+
+  std::thread worker_;
+  std::mutex mutex_;
+  std::condition_variable requested_;
+  // Guarded by mutex_
+  std::deque<LevelChunkCoord> requests_;
+  std::vector<LevelChunk> loaded_;
+  bool stopping_{false};
+};
+
+}  // namespace platformer2d
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "level/level_file.h"
+#include "level_editor/tile_map.h"
+
+namespace platformer2d {
+
+// Saves the editor's level on a background thread so the editor never waits
+// on serialising or disk. save() snapshots the map and returns, the thread
+// then writes the json and binary levels with writeFileAtomic, json first
+// so the binary is never older. A crash mid save leaves the previous files.
+//
+// Neither format can be patched in place, so both are always rewritten
+// whole. What the dirty chunks do save is the json serialising: rows the
+// last save wrote are kept as text and only rows crossing a dirty chunk are
+// serialised again.
+class LevelSaver {
+ public:
+  LevelSaver(std::string json_path, std::string binary_path);
+  // Finishes a save in progress or queued so no edits are lost
+  ~LevelSaver();
+
+  LevelSaver(const LevelSaver&) = delete;
+  LevelSaver& operator=(const LevelSaver&) = delete;
+
+  // Snapshots the map and clears its dirty chunks. Replaces a snapshot
+  // still waiting to be written.
+  void save(TileMap& tile_map);
+  // Blocks until every snapshot handed to save() has been written, for when
+  // something is about to read the files back
+  void flush();
+  // The last save could not be written, the map should be saved again
+  bool hasFailed() const { return failed_; }
+
+ private:
+  struct Snapshot {
+    LevelData level;
+    std::vector<uint8_t> dirty_rows;
+  };
+
+  void saveWorker();
+  bool writeSnapshot(const Snapshot& snapshot);
+
+  const std::string json_path_;
+  const std::string binary_path_;
+
+  std::thread worker_;
+  std::mutex mutex_;
+  std::condition_variable requested_;
+  std::condition_variable idle_;
+  // Guarded by mutex_
+  std::optional<Snapshot> pending_;
+  bool writing_{false};
+  bool stopping_{false};
+
+  std::atomic<bool> failed_{false};
+  // Worker only. Each row's json from the last save, empty once invalid.
+  std::vector<std::string> row_json_;
+  // Width of the level the cached rows were written for
+  uint32_t row_json_width_{0};
+};
+
+}  // namespace platformer2d
@@ -1,23 +1,14 @@
 #pragma once
 
-#include <string>
-
-#include "nlohmann/json.hpp"
+#include "managers/texture_handle.h"
 
 namespace platformer2d {
 
 struct Tile {
   int x;
   int y;
-  std::string texture_name;
-
-  nlohmann::json toJson() const {
-    nlohmann::json json;
-    json["x"] = x;
-    json["y"] = y;
-    json["texture_name"] = texture_name;
-    return json;
-  }
+  // kInvalidTexture for an empty tile
+  TextureHandle texture{kInvalidTexture};
 };
 
 }  // namespace platformer2d
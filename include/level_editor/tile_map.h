@@ -1,49 +1,196 @@
 #pragma once
 
 #include <cstddef>
-#include <functional>
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <memory>
 #include <optional>
+#include <span>
 #include <vector>
 
+#include "constants.h"
+#include "level/level_file.h"
 #include "level_editor/tile.h"
 #include "managers/asset_manager.h"
-#include "nlohmann/json.hpp"
+#include "render/render_command_list.h"
 
 namespace platformer2d {
 
-using TilesVec = std::vector<std::vector<Tile>>;
+// Half open range of grid cells, [start, end) on each axis
+struct TileRange {
+  size_t start_x;
+  size_t start_y;
+  size_t end_x;
+  size_t end_y;
+};
+
+// A block of tiles copied out of a map, row major
+struct TileRegion {
+  size_t width{0};
+  size_t height{0};
+  // kInvalidTexture for an empty cell
+  std::vector<TextureHandle> textures;
+};
 
 /**
- *  Internal model of the tile map is an vector of vectors
- *  [
- *    [ max_tiles_x  ],
- *    ..., size max_tiles_y
- *  ]
- *
+ *  Internal model of the tile map is a grid of kLevelChunkSize square
+ *  chunks, each holding the palette indices of its cells as the same
+ *  LevelTileId the binary level format uses (0 is empty, otherwise palette
+ *  index + 1). A chunk is only allocated once a tile is placed in it and is
+ *  freed again when its last tile is cleared, so memory follows the painted
+ *  area rather than max_tiles_x * max_tiles_y.
+ *  Tile positions are not stored, they follow from the grid cell and the
+ *  map's origin. A bit per cell marks the placed tiles so drawing skips
+ *  empty space a row of a chunk at a time.
  */
 class TileMap {
  public:
-  TileMap(size_t max_tiles_x, size_t max_tiles_y, AssetManager& asset_manager);
-  // Return false in case of out of bounds
-  bool addTile(size_t tile_x, size_t tile_y, float pos_x, float pos_y,
-               std::string texture_name);
-  std::optional<std::reference_wrapper<const Tile>> getTile(
-      size_t tile_x, size_t tile_y) const;
-  const TilesVec& getTiles() const;
-  void draw() const;
-  nlohmann::json toJson() const;
-  void fromJson(const nlohmann::json& json);
+  TileMap(size_t max_tiles_x, size_t max_tiles_y, AssetManager& asset_manager,
+          float origin_x = 0, float origin_y = 0);
+  // Return false in case of out of bounds. kInvalidTexture clears the cell.
+  bool addTile(size_t tile_x, size_t tile_y, TextureHandle texture);
+  std::optional<Tile> getTile(size_t tile_x, size_t tile_y) const;
+
+  // Bulk edits. Each writes a chunk row at a time and marks only the chunks
+  // whose cells actually changed as dirty.
+  // Sets every cell in range. Return false if range is not inside the map.
+  bool fillRect(const TileRange& range, TextureHandle texture);
+  // Sets the area of cells connected (not diagonally) to tile_x, tile_y that
+  // hold the same tile as it. Return false in case of out of bounds.
+  // Only starts the fill, continueFloodFill() does the work so a huge area
+  // can be spread over several frames. A fill still running is finished
+  // first.
+  bool floodFill(size_t tile_x, size_t tile_y, TextureHandle texture);
+  // Fills roughly max_cells more cells (counting the ones searched), returns
+  // true once no fill is running
+  bool continueFloodFill(size_t max_cells);
+  bool isFloodFilling() const { return !fill_spans_.empty(); }
+  // The cells of range, clipped to the map
+  TileRegion copyRegion(const TileRange& range) const;
+  // Writes region with its top left at tile_x, tile_y, empty cells included.
+  // Whatever falls off the map is dropped. Return false in case of out of
+  // bounds.
+  bool pasteRegion(const TileRegion& region, size_t tile_x, size_t tile_y);
+
+  void draw(RenderCommandList& commands) const;
+  // Only draws the tiles overlapping view, given in world coordinates
+  void draw(RenderCommandList& commands, const Rectangle& view) const;
+  // The cells overlapping view, empty if it misses the map
+  TileRange getVisibleTiles(const Rectangle& view) const;
+  // Streams the json level in, returns false if it is malformed. Tiles are
+  // snapped to this map's grid.
+  bool fromJson(std::istream& input);
+  // Tiles are saved by texture name and resolved to handles on load. The
+  // saved level only spans the grid up to the last painted row and column.
+  LevelData toLevelData() const;
+  // Cells outside the map are dropped
+  void fromLevelData(const LevelData& level);
+
+  // Chunks (kLevelChunkSize square) changed since the last clearDirty()
+  bool hasChanges() const { return num_dirty_chunks_ > 0; }
+  bool isChunkDirty(size_t chunk_x, size_t chunk_y) const {
+    return dirty_chunks_[chunk_y * num_chunks_x_ + chunk_x];
+  }
+  size_t getNumChunksX() const { return num_chunks_x_; }
+  size_t getNumChunksY() const { return num_chunks_y_; }
+  void clearDirty();
+
+  size_t getMaxTilesX() const { return max_tiles_x_; }
 
-  size_t getMaxTilesX() { return max_tiles_x_; }
+  size_t getMaxTilesY() const { return max_tiles_y_; }
 
-  size_t getMaxTilesY() { return max_tiles_y_; }
+  float getOriginX() const { return origin_x_; }
+
+  float getOriginY() const { return origin_y_; }
+
+  // Chunks currently holding at least one tile
+  size_t getNumAllocatedChunks() const { return num_allocated_chunks_; }
 
  private:
+  static constexpr size_t kChunkCells{kLevelChunkSize * kLevelChunkSize};
+  // Bits of one chunk row, a row never straddles two words
+  static constexpr size_t kChunkRowsPerWord{64 / kLevelChunkSize};
+  static constexpr uint64_t kChunkRowMask{(uint64_t{1} << kLevelChunkSize) -
+                                          1};
+
+  // Cells [start_x, end_x) of row y still to search, next to a filled run
+  // in row y - dy
+  struct FillSpan {
+    size_t start_x;
+    size_t end_x;
+    size_t y;
+    int dy;
+  };
+
+  struct Chunk {
+    std::array<LevelTileId, kChunkCells> tiles{};
+    std::array<uint64_t, kChunkCells / 64> occupied{};
+    size_t num_tiles{0};
+  };
+
+  // The occupied bits of one row of a chunk, bit x set for column x
+  static uint64_t getChunkRow(const Chunk& chunk, size_t row) {
+    return chunk.occupied[row / kChunkRowsPerWord] >>
+               (row % kChunkRowsPerWord * kLevelChunkSize) &
+           kChunkRowMask;
+  }
+  static size_t getChunkCell(size_t tile_x, size_t tile_y) {
+    return (tile_y % kLevelChunkSize) * kLevelChunkSize +
+           tile_x % kLevelChunkSize;
+  }
+
+  const Chunk* findChunk(size_t tile_x, size_t tile_y) const {
+    return chunks_[(tile_y / kLevelChunkSize) * num_chunks_x_ +
+                   tile_x / kLevelChunkSize]
+        .get();
+  }
   bool isInBounds(size_t tile_x, size_t tile_y) const;
+  LevelTileId getCell(size_t tile_x, size_t tile_y) const;
+  // Both write row tile_y a chunk at a time, the cells must be in the map
+  void fillRow(size_t start_x, size_t end_x, size_t tile_y, LevelTileId id);
+  void writeRow(size_t start_x, size_t tile_y,
+                std::span<const LevelTileId> ids);
+  // Sets the occupied bits of columns in a chunk row after its cells
+  // changed, marks the chunk dirty and frees it if it is empty now
+  void updateChunkRow(std::unique_ptr<Chunk>& chunk, size_t chunk_x,
+                      size_t tile_y, uint64_t columns, uint64_t placed);
+  // Bit x set where column x of the chunk's row tile_y holds id
+  uint64_t getMatchingCells(size_t chunk_x, size_t tile_y,
+                            LevelTileId id) const;
+  // First column in [start_x, end_x) of row tile_y holding id, else end_x
+  size_t findCell(size_t start_x, size_t end_x, size_t tile_y,
+                  LevelTileId id) const;
+  // Ends of the run of id cells around tile_x, end exclusive
+  size_t getRunStart(size_t tile_x, size_t tile_y, LevelTileId id) const;
+  size_t getRunEnd(size_t tile_x, size_t tile_y, LevelTileId id) const;
+  // Queues the cells of row tile_y + dy next to a filled run, if on the map
+  void pushFillSpan(size_t start_x, size_t end_x, size_t tile_y, int dy);
+  void markDirty(size_t tile_x, size_t tile_y);
+  LevelTileId getTileId(TextureHandle texture);
+  TextureHandle getTexture(LevelTileId tile) const {
+    return tile == kEmptyLevelTile ? kInvalidTexture : palette_[tile - 1];
+  }
 
   size_t max_tiles_x_;
   size_t max_tiles_y_;
-  TilesVec tiles_;
+  float origin_x_;
+  float origin_y_;
+  // Textures in the order they were first placed
+  std::vector<TextureHandle> palette_;
+  // Texture handle to tile id, kEmptyLevelTile if not in the palette yet
+  std::vector<LevelTileId> palette_ids_;
+  size_t num_chunks_x_;
+  size_t num_chunks_y_;
+  // Row major by chunk, null where nothing is painted
+  std::vector<std::unique_ptr<Chunk>> chunks_;
+  size_t num_allocated_chunks_{0};
+  std::vector<uint8_t> dirty_chunks_;
+  size_t num_dirty_chunks_{0};
+  // The flood fill in progress, if fill_spans_ isn't empty
+  std::vector<FillSpan> fill_spans_;
+  LevelTileId fill_target_{kEmptyLevelTile};
+  LevelTileId fill_tile_{kEmptyLevelTile};
   AssetManager& asset_manager_;
 };
 
@@ -14,9 +14,9 @@ constexpr float right_border_x{kScreenWidth + kTilePickerWidth};
 class TilePicker {
  public:
   TilePicker(AssetManager& asset_manager);
-  void draw() const;
-  void setCurrentTextureName(int mouse_x, int mouse_y);
-  std::string getCurrentTextureName() const;
+  void draw(RenderCommandList& commands) const;
+  void setCurrentTexture(int mouse_x, int mouse_y);
+  TextureHandle getCurrentTexture() const;
   Tile getTile(size_t count_x, size_t count_y);
 
   // Fill the tile map with all tiles and sprites.
@@ -27,7 +27,7 @@ class TilePicker {
 
  private:
   const AssetManager& asset_manager_;
-  std::string current_texture_name_;
+  TextureHandle current_texture_;
   TileMap tile_map_;
 };
 
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+namespace platformer2d {
+
+enum class LogLevel : uint8_t { kDebug, kInfo, kWarning, kError };
+
+// Longer lines are cut short
+constexpr size_t kLogLineSize{240};
+// Lines a thread can have waiting for the writer before new ones are dropped
+constexpr size_t kLogLinesPerThread{1024};
+
+// Formats one line into a fixed buffer, never allocating
+class LogLineBuffer : public std::streambuf {
+ public:
+  LogLineBuffer() { reset(); }
+  void reset() { setp(text_, text_ + kLogLineSize); }
+  const char* getText() const { return text_; }
+  size_t getLength() const { return pptr() - pbase(); }
+
+ private:
+  char text_[kLogLineSize];
+};
+
+// Logging that never blocks the caller on output. The line is formatted on
+// the calling thread into a fixed buffer and pushed onto that thread's lock
+// free ring with its level and time, and a background thread turns it into
+// the final output and writes it, in time order across threads. If a ring is
+// full the line is dropped and counted rather than waiting.
+//
+// Use the DLOG, LOG_INFO, LOG_WARNING and LOG_ERROR macros from debug.h.
+class Logger {
+ public:
+  static Logger& get();
+
+  Logger(const Logger&) = delete;
+  Logger& operator=(const Logger&) = delete;
+
+  // Stream for the calling thread's next line, finished by endLine
+  std::ostream& beginLine();
+  void endLine(LogLevel level);
+
+  // Write everything logged so far before returning. Safe to call from any
+  // thread, PANIC and CHECK call it before aborting.
+  void flush();
+
+ private:
+  struct Line {
+    uint64_t time_ns;
+    LogLevel level;
+    uint16_t length;
+    char text[kLogLineSize];
+  };
+  struct ThreadBuffer;
+  // Hands the calling thread's buffer back when the thread exits
+  struct ThreadSlot;
+
+  Logger();
+
+  ThreadBuffer& getThreadBuffer();
+  void writerLoop();
+  // Stops the writer and writes what is left
+  static void flushAtExit();
+  // Drain every ring and write the lines. Only with consumer_mutex_ held.
+  void writePending();
+
+  // Guards the buffer list, taken when a thread first logs or exits
+  std::mutex buffers_mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+  // The writer thread and flush both consume, one at a time
+  std::mutex consumer_mutex_;
+  std::vector<Line> pending_;
+
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  std::atomic<bool> stopping_{false};
+  std::thread writer_;
+
+  static thread_local ThreadBuffer* thread_buffer_;
+};
+
+}  // namespace platformer2d
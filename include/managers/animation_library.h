@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "managers/asset_manager.h"
+#include "managers/manager.h"
+#include "raylib.h"
+
+namespace platformer2d {
+
+using AnimationClipId = uint16_t;
+constexpr AnimationClipId kInvalidAnimationClip{
+    std::numeric_limits<AnimationClipId>::max()};
+
+using AnimationStateMachineId = uint16_t;
+using AnimationStateIndex = uint8_t;  // Local to its state machine
+
+// Bits describing what an entity is doing. Transitions test these.
+constexpr uint8_t kConditionMoving{1 << 0};
+constexpr uint8_t kConditionGrounded{1 << 1};
+constexpr uint8_t kConditionFacingRight{1 << 2};
+constexpr uint8_t kConditionRising{1 << 3};
+constexpr uint8_t kConditionFalling{1 << 4};
+
+struct AnimationFrame {
+  Rectangle source;  // Region of the clip's texture for this frame
+  float duration;    // Seconds the frame is shown for
+};
+
+// A clip is a run of frames in the library's shared frame array
+struct AnimationClip {
+  TextureHandle texture;
+  uint32_t first_frame;
+  uint16_t num_frames;
+};
+
+// Fires when (conditions & mask) == value
+struct AnimationTransition {
+  uint8_t mask;
+  uint8_t value;
+  AnimationStateIndex to_state;
+};
+
+struct AnimationMachineState {
+  AnimationClipId clip;
+  uint32_t first_transition;  // Into the library's shared transition table
+  uint16_t num_transitions;
+};
+
+struct AnimationStateMachine {
+  uint32_t first_state;  // Into the library's shared state table
+  uint16_t num_states;
+  AnimationStateIndex initial_state;
+};
+
+// Owns every animation clip. Clips are defined once in data, compiled to
+// precomputed frame rectangles when loaded and then referred to by a small
+// AnimationClipId from each AnimationComponent. Names are only resolved at
+// load time.
+//
+// Clip file format:
+// {"clips": [{"name": "...", "texture": "<asset name>", "num_frames": 4,
+//             "frame_duration": 0.4, "frame_durations": [optional, ...]}]}
+//
+// It also owns the animation state machines. Each machine's states map to a
+// clip and each state's outgoing transitions are a contiguous run in one
+// shared table, checked in order, so evaluating a machine is a couple of
+// array lookups and mask compares.
+//
+// State machine file format:
+// {"state_machines": [{"name": "...", "initial_state": "idle",
+//   "states": [{"name": "idle", "clip": "<clip name>"}, ...],
+//   "transitions": [{"from": "idle" or "*", "to": "running",
+//                    "when": ["moving", "!falling", ...]}, ...]}]}
+//
+// Conditions are moving, grounded, facing_right, rising and falling, with a
+// leading '!' to negate. Transitions from "*" apply to every other state
+// after that state's own transitions.
+class AnimationLibrary : public Manager {
+ public:
+  AnimationLibrary() = default;
+
+  // Textures referenced by the clips must be registered with the asset
+  // manager and their size known. They are acquired for the lifetime of the
+  // library. Returns false if the file could not be opened or parsed.
+  bool loadFromFile(const std::string& path, AssetManager& assets);
+  // texture_size is the texture's size in pixels, used to lay out frames
+  AnimationClipId addClip(const std::string& name, TextureHandle texture,
+                          Vector2 texture_size, uint16_t num_frames,
+                          const std::vector<float>& frame_durations);
+
+  // Clips used by the machines must already be loaded. Returns false if the
+  // file could not be opened or parsed.
+  bool loadStateMachinesFromFile(const std::string& path);
+
+  // Load time lookups, panic if the clip or machine does not exist
+  AnimationClipId getClipId(const std::string& name) const;
+  AnimationStateMachineId getStateMachineId(const std::string& name) const;
+
+  const AnimationStateMachine& getStateMachine(
+      AnimationStateMachineId id) const {
+    return state_machines_[id];
+  }
+
+  const AnimationMachineState& getState(const AnimationStateMachine& machine,
+                                        AnimationStateIndex state) const {
+    return machine_states_[machine.first_state + state];
+  }
+
+  const AnimationTransition& getTransition(uint32_t index) const {
+    return transitions_[index];
+  }
+
+  const AnimationClip& getClip(AnimationClipId id) const {
+    return clips_[id];
+  }
+
+  const AnimationFrame& getFrame(const AnimationClip& clip,
+                                 uint16_t frame_index) const {
+    return frames_[clip.first_frame + frame_index];
+  }
+
+ private:
+  std::vector<AnimationClip> clips_;
+  std::vector<AnimationFrame> frames_;
+  std::unordered_map<std::string, AnimationClipId> clip_ids_;
+
+  std::vector<AnimationStateMachine> state_machines_;
+  std::vector<AnimationMachineState> machine_states_;
+  std::vector<AnimationTransition> transitions_;
+  std::unordered_map<std::string, AnimationStateMachineId> state_machine_ids_;
+};
+
+}  // namespace platformer2d
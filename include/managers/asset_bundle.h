@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+#include "raylib.h"
+
+namespace platformer2d {
+
+enum class BundleCompression : uint32_t {
+  kNone = 0,
+  kLz = 1,  // LZ4 block format
+};
+
+// One texture in a bundle, stored on disk exactly as laid out here
+struct AssetBundleEntry {
+  uint32_t name_offset;  // Into the bundle's string table
+  uint32_t name_length;
+  uint32_t path_offset;  // Source png the pixels were decoded from
+  uint32_t path_length;
+  uint16_t width;
+  uint16_t height;
+  uint16_t display_width;  // 0 means the pixel size
+  uint16_t display_height;
+  uint32_t format;  // raylib PixelFormat
+  BundleCompression compression;
+  uint64_t data_offset;  // From the start of the file
+  uint64_t stored_size;  // Bytes in the file
+  uint64_t raw_size;     // Bytes once decompressed
+};
+static_assert(sizeof(AssetBundleEntry) == 56);
+
+// A bundle packs pre-decoded pixels for many textures into one file so
+// startup is one sequential read instead of opening and inflating every png.
+// Built offline by tools/asset_bundle.cpp (asset_bundle build target).
+//
+// Layout: 16 byte header ("P2DB", version, entry count, string table size),
+// the entry table, the string table, then each entry's pixels 16 byte
+// aligned.
+//
+// The file is memory mapped read only and stays mapped while open.
+class AssetBundle {
+ public:
+  AssetBundle() = default;
+  ~AssetBundle();
+
+  AssetBundle(const AssetBundle&) = delete;
+  AssetBundle& operator=(const AssetBundle&) = delete;
+
+  // Returns false if the file is missing or not a valid bundle
+  bool open(const std::string& path);
+  void close();
+  bool isOpen() const { return file_.isOpen(); }
+
+  std::span<const AssetBundleEntry> getEntries() const { return entries_; }
+  // nullptr if there is no entry with that name
+  const AssetBundleEntry* find(std::string_view name) const;
+  std::string_view getName(const AssetBundleEntry& entry) const;
+  std::string_view getSourcePath(const AssetBundleEntry& entry) const;
+
+  // The entry's pixels ready to upload. Uncompressed pixels point straight
+  // into the mapping and owned is false, they must not be unloaded.
+  // Compressed ones are inflated into a new buffer, owned is true and the
+  // caller frees it with UnloadImage. Safe to call from any thread. Returns
+  // an image with null data if the entry is corrupt.
+  Image loadImage(const AssetBundleEntry& entry, bool& owned) const;
+
+ private:
+  MappedFile file_;
+  std::span<const AssetBundleEntry> entries_;
+  const char* strings_{nullptr};
+  std::unordered_map<std::string_view, size_t> entry_index_;
+};
+
+// Accumulates decoded images and writes them out as a bundle
+class AssetBundleWriter {
+ public:
+  // Copies the image's pixels. Compressed data is only kept if it is smaller.
+  void addImage(const std::string& name, const std::string& source_path,
+                int display_width, int display_height, const Image& image,
+                bool compress);
+  // Replaces the file with writeFileAtomic, returns false if it could not
+  // be written
+  bool write(const std::string& path) const;
+
+  uint64_t getRawBytes() const { return raw_bytes_; }
+  uint64_t getStoredBytes() const { return stored_bytes_; }
+
+ private:
+  struct PendingImage {
+    std::string name;
+    std::string source_path;
+    AssetBundleEntry entry;
+    std::vector<uint8_t> data;
+  };
+
+  std::vector<PendingImage> images_;
+  uint64_t raw_bytes_{0};
+  uint64_t stored_bytes_{0};
+};
+
+}  // namespace platformer2d
@@ -1,18 +1,79 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include "managers/asset_bundle.h"
+#include "managers/asset_manifest.h"
 #include "managers/manager.h"
+#include "managers/texture_handle.h"
 #include "raylib.h"
 
 namespace platformer2d {
 
-using TextureMap = std::unordered_map<std::string, Texture2D>;
+// Everything known about a texture whether or not it is resident
+struct TextureEntry {
+  std::string name;
+  std::string filename;
+  // Size to draw at, 0 keeps the image's own size
+  int display_width{0};
+  int display_height{0};
+  // Valid GPU texture once loaded. Before that and after unloading the id is
+  // 0 but the size is kept when known.
+  Texture2D texture{};
+  bool loaded{false};
+  bool queued{false};
+  int ref_count{0};
+  size_t bytes{0};  // Pixel memory while resident
+  uint64_t last_used_frame{0};
+  // Pre-decoded pixels in the mounted bundle, nullptr loads the png
+  const AssetBundleEntry* bundled{nullptr};
+};
+
+struct TextureStats {
+  size_t resident_bytes{0};
+  size_t peak_resident_bytes{0};
+  size_t resident_textures{0};
+  size_t budget_bytes{0};  // 0 is unlimited
+  // getTexture calls that found the texture resident or had to load it
+  uint64_t hits{0};
+  uint64_t misses{0};
+  uint64_t evictions{0};
+};
 
+struct LoadingProgress {
+  size_t uploaded{0};
+  size_t total{0};
+
+  bool isComplete() const { return uploaded == total; }
+};
+
+// Owns all textures. Textures are registered up front (usually from the
+// asset manifest) but only loaded when first needed: either when a scene
+// acquires them, which decodes them in parallel in the background, or on
+// the first getTexture. Scenes acquire the textures they use and release
+// them when destroyed, releaseUnused() then frees whatever nothing holds.
+//
+// Resident textures are accounted by their pixel size. With a memory budget
+// set, endFrame() evicts the least recently drawn textures until back under
+// it and they reload transparently the next time getTexture asks for them.
+//
+// Each texture gets a TextureHandle when registered. Names are only for
+// load and edit time, everything per frame goes through handles which index
+// straight into the texture array.
 class AssetManager : public Manager {
  public:
-  AssetManager();
+  // A headless AssetManager decodes images only to learn their size and never
+  // uploads to the GPU, so it works without a window. Textures it hands out
+  // have an id of 0 and must not be drawn with raylib.
+  explicit AssetManager(bool headless = false);
   ~AssetManager();
 
   // Should be a singleton effectively so remving copy and move constructors
@@ -21,16 +82,139 @@ class AssetManager : public Manager {
   AssetManager(AssetManager&&) = delete;
   AssetManager& operator=(AssetManager&&) = delete;
 
-  void loadTexture(const std::string& name, const std::string& filename);
-  void loadTexture(const std::string& name, const std::string& filename,
-                   int width, int height);
+  // Register every texture in the manifest without loading any. Registering
+  // a name twice returns the existing handle.
+  void registerManifest(const AssetManifest& manifest);
+  TextureHandle registerTexture(const std::string& name,
+                                const std::string& filename, int width = 0,
+                                int height = 0);
+
+  // Take pixels for every texture in the bundle from its memory mapped data
+  // instead of decoding pngs. Textures not registered yet are registered.
+  // Entries built from a different file than the one registered under that
+  // name are stale and ignored. Returns false if the bundle can't be opened.
+  bool mountBundle(const std::string& path);
+
+  // Load straight away on the calling thread
+  TextureHandle loadTexture(const std::string& name,
+                            const std::string& filename);
+  TextureHandle loadTexture(const std::string& name,
+                            const std::string& filename, int width,
+                            int height);
+
+  // Name lookups for load and edit time. getHandle panics on an unknown
+  // name, findHandle returns kInvalidTexture.
+  TextureHandle getHandle(const std::string& name) const;
+  TextureHandle findHandle(const std::string& name) const;
+  const std::string& getName(TextureHandle handle) const {
+    return textures_[handle].name;
+  }
 
-  const TextureMap& getTextures() const { return textures_; }
+  // Reference counting. Acquiring a texture that is not resident queues it
+  // for the asynchronous loader, call startLoading() once done acquiring.
+  void acquireTexture(TextureHandle handle);
+  void releaseTexture(TextureHandle handle);
+  // Unload every resident texture nobody holds. Main thread only.
+  size_t releaseUnused();
+  // The file at path changed on disk. Resident textures loaded from it are
+  // reloaded straight away, others pick it up when next loaded. Handles stay
+  // the same. Returns the number reloaded. Main thread only.
+  size_t reloadFile(const std::string& path);
 
-  const Texture2D& getTexture(const std::string& name) const;
+  // Memory budget for resident textures in bytes, 0 for no limit. Textures
+  // in use are never evicted so the budget can be exceeded when a single
+  // frame needs more than it.
+  void setMemoryBudget(size_t bytes) { stats_.budget_bytes = bytes; }
+  // Marks the end of a frame's drawing and, while over budget, evicts the
+  // least recently used textures that haven't been drawn for a few frames.
+  // Main thread only.
+  void endFrame();
+  const TextureStats& getStats() const { return stats_; }
+
+  // Asynchronous loading. Queue a batch of textures then startLoading()
+  // decodes them in parallel on worker threads. Decoded images wait until
+  // the main thread uploads them with uploadPendingTextures() or
+  // finishLoading(), since only the main thread may talk to the GPU.
+  // width and height of 0 keep the image's own size.
+  TextureHandle queueTexture(const std::string& name,
+                             const std::string& filename, int width = 0,
+                             int height = 0);
+  // num_threads of 0 uses one worker per hardware thread. Does nothing if
+  // workers are already running.
+  void startLoading(unsigned int num_threads = 0);
+  // Upload decoded images until budget_seconds has been spent. Always
+  // uploads at least one if one is ready. Returns the number uploaded.
+  size_t uploadPendingTextures(double budget_seconds);
+  // Block until everything queued has been decoded and uploaded
+  void finishLoading();
+  LoadingProgress getLoadingProgress() const;
+
+  // Indexed by TextureHandle
+  const std::vector<TextureEntry>& getTextures() const { return textures_; }
+
+  // Loads the texture first if it is not resident. The reference sees later
+  // loads and unloads but is only valid until the next registration.
+  const Texture2D& getTexture(TextureHandle handle) {
+    TextureEntry& entry = textures_[handle];
+    entry.last_used_frame = frame_;
+    if (entry.loaded) {
+      ++stats_.hits;
+    } else {
+      ++stats_.misses;
+      loadOnDemand(entry);
+    }
+    return entry.texture;
+  }
+  // Same as getTexture but never loads. The size is valid if it was in the
+  // manifest or the texture has been loaded before.
+  const Texture2D& peekTexture(TextureHandle handle) const {
+    return textures_[handle].texture;
+  }
+  bool isLoaded(TextureHandle handle) const {
+    return textures_[handle].loaded;
+  }
+
+  bool isHeadless() const { return headless_; }
 
  private:
-  std::unordered_map<std::string, Texture2D> textures_;
+  struct TextureRequest {
+    TextureHandle handle;
+    std::string filename;
+    const AssetBundleEntry* bundled;
+  };
+
+  struct DecodedImage {
+    size_t request_index;
+    Image image;
+    bool owned;  // False when the pixels live in the bundle's mapping
+  };
+
+  bool headless_;
+  std::vector<TextureEntry> textures_;
+  std::unordered_map<std::string, TextureHandle> handles_;
+  AssetBundle bundle_;
+  TextureStats stats_;
+  uint64_t frame_{0};
+
+  // Async loading state. requests_ is read only while workers run.
+  std::vector<TextureRequest> requests_;
+  std::atomic<size_t> next_request_{0};
+  std::vector<std::thread> workers_;
+  mutable std::mutex decoded_mutex_;
+  std::condition_variable decoded_ready_;
+  std::vector<DecodedImage> decoded_;  // Guarded by decoded_mutex_
+  size_t num_uploaded_{0};
+
+  void loadOnDemand(TextureEntry& entry);
+  void loadEntry(TextureEntry& entry);
+  Image decodeImage(const std::string& filename,
+                    const AssetBundleEntry* bundled, bool& owned) const;
+  void setTexture(TextureEntry& entry, Texture2D texture);
+  void unloadEntry(TextureEntry& entry);
+  Texture2D textureFromImage(const Image& image) const;
+  void decodeWorker();
+  void uploadDecoded(const DecodedImage& decoded);
+  void joinWorkers();
 };
 
 }  // namespace platformer2d
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace platformer2d {
+
+struct AssetManifestEntry {
+  std::string name;    // Logical name used by the game and level files
+  std::string path;    // Path from the working directory, e.g. assets/x.png
+  uint64_t bytes{0};   // File size on disk
+  int width{0};        // Pixel size of the image
+  int height{0};
+  int display_width{0};  // Size to draw at, 0 means the pixel size
+  int display_height{0};
+};
+
+// Describes every asset the game can load without loading any of them.
+// Generated offline by scanning assets/ (see tools/asset_manifest.cpp) and
+// stored as assets/manifest.json:
+//
+// {"assets": [{"name": "...", "path": "...", "bytes": 1234, "width": 32,
+//              "height": 32, "display_width": 50, "display_height": 50}]}
+class AssetManifest {
+ public:
+  AssetManifest() = default;
+
+  // Both return false if the file could not be opened or parsed. Loading
+  // skips entries without a name and path and ignores sizes that are not.
+  bool loadFromFile(const std::string& path);
+  bool saveToFile(const std::string& path) const;
+
+  // Build a manifest from every png under root. Assets whose path is already
+  // in previous keep their name so renaming files on disk is the only way to
+  // break level files. New assets get a name derived from their path: images
+  // in a sub directory are tiles named tile_<dir>_<stem> and drawn at
+  // kTileSize, anything else is named after its lower cased stem.
+  static AssetManifest scan(const std::string& root,
+                            const AssetManifest* previous = nullptr);
+
+  const std::vector<AssetManifestEntry>& getEntries() const {
+    return entries_;
+  }
+
+ private:
+  std::vector<AssetManifestEntry> entries_;  // Sorted by path
+};
+
+}  // namespace platformer2d
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "managers/manager.h"
+
+namespace platformer2d {
+
+// Reports files that have been written or moved into place, so assets can be
+// reloaded while the game runs. Uses inotify so only works on Linux,
+// elsewhere nothing is ever reported.
+class FileWatcher : public Manager {
+ public:
+  FileWatcher();
+  ~FileWatcher();
+
+  // Watch every file in directory and, if recursive, in the directories
+  // below it as they are now. Returns false if it cannot be watched.
+  bool watchDirectory(const std::string& directory, bool recursive = true);
+
+  // Paths of files changed since the last poll, each once, spelled
+  // <watched directory>/<file name>. Never blocks.
+  std::vector<std::string> poll();
+
+ private:
+  int fd_{-1};
+  std::unordered_map<int, std::string> directories_;  // By watch descriptor
+};
+
+}  // namespace platformer2d
@@ -4,10 +4,44 @@
 
 namespace platformer2d {
 
+// Snapshot of everything the game reads from the input devices in one tick.
+// Kept as plain data so it can be fed in from somewhere other than raylib
+// (headless runs, scripts).
+struct InputState {
+  bool is_space{false};
+  bool is_left{false};
+  bool is_right{false};
+
+  // Level editor input, only polled in DEBUG builds
+  bool is_e_pressed{false};
+  bool is_s_pressed{false};
+  bool is_t_pressed{false};
+  bool is_up{false};
+  bool is_down{false};
+  // Wheel notches this tick, positive away from the user
+  float mouse_wheel{0};
+  bool is_mouse_clicked{false};
+  int mouse_position_x{0};
+  int mouse_position_y{0};
+
+  // Profiler overlay and capture toggles, only polled in profiling builds
+  bool is_f3_pressed{false};
+  bool is_f4_pressed{false};
+
+  bool operator==(const InputState&) const = default;
+};
+
 class InputManager : public Manager {
  public:
   InputManager();
+  // Poll the raylib window for this tick's input
   void getInput();
+  // Read the raylib window's input without storing it. Main thread only.
+  static InputState pollInput();
+  // Use the given state for this tick instead of polling raylib
+  void setInput(const InputState& state);
+  const InputState& getState() const { return state_; }
+
   bool isRight() const;
   bool isLeft() const;
   bool isSpace() const;
@@ -15,23 +49,22 @@ class InputManager : public Manager {
 #ifndef NDEBUG
   bool isEPressed() const;
   bool isSPressed() const;
+  bool isTPressed() const;
+  bool isUp() const;
+  bool isDown() const;
+  float getMouseWheel() const;
   bool mouseClicked() const;
   int getMousePositionX() const;
   int getMousePositionY() const;
 #endif
 
- private:
-  bool is_space_;
-  bool is_left_;
-  bool is_right_;
-
-#ifndef NDEBUG
-  bool is_e_pressed_;
-  bool is_s_pressed_;
-  bool is_mouse_clicked_;
-  int mouse_position_x_;
-  int mouse_position_y_;
+#ifdef PLATFORMER2D_PROFILE
+  bool isF3Pressed() const;
+  bool isF4Pressed() const;
 #endif
+
+ private:
+  InputState state_;
 };
 
 }  // namespace platformer2d
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "constants.h"
+#include "managers/input_manager.h"
+
+namespace platformer2d {
+
+// Every tick's input from a fixed timestep run, so the run can be played
+// back exactly. Consecutive ticks with the same input are kept as one run,
+// so holding a key for a minute costs the same as one tick. Saved as a
+// small binary file: a header and then one fixed size record per run.
+class InputRecording {
+ public:
+  InputRecording() = default;
+
+  // Drops everything recorded, later ticks are timestep seconds apart
+  void reset(float timestep);
+  // Append the input of the next tick
+  void record(const InputState& state);
+  // Input of the given tick, nothing past the end of the recording
+  InputState getInput(uint64_t tick) const;
+
+  uint64_t getTickCount() const { return num_ticks_; }
+  float getTimestep() const { return timestep_; }
+
+  // Both return false if the file could not be read or written, loading
+  // also fails if the file is not a valid recording
+  bool loadFromFile(const std::string& path);
+  bool saveToFile(const std::string& path) const;
+
+ private:
+  struct Run {
+    uint64_t first_tick;
+    InputState state;
+  };
+
+  std::vector<Run> runs_;  // Sorted by first_tick
+  uint64_t num_ticks_{0};
+  float timestep_{kFixedTimestep};
+};
+
+}  // namespace platformer2d
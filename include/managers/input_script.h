@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "managers/input_manager.h"
+
+namespace platformer2d {
+
+// Scripted input for runs without a window. A script is a text file with one
+// entry per line:
+//
+//   <tick> <keys> [<mouse x> <mouse y>]
+//
+// where keys is any combination of R (right), L (left), U (up), D (down),
+// J (jump), E, S, T, I (wheel in), O (wheel out) and M (mouse click, at the
+// position following the keys), or '-' for nothing. Lines starting with '#'
+// are comments. R, L, U and D are held from the entry's tick until the next
+// entry, the rest are key presses, wheel notches or clicks and only fire on
+// the entry's tick. An empty script produces no input at all.
+class InputScript {
+ public:
+  InputScript() = default;
+
+  // Returns false if the file could not be opened or a line is malformed
+  bool loadFromFile(const std::string& path);
+  InputState getInput(uint64_t tick) const;
+
+ private:
+  struct Entry {
+    uint64_t tick;
+    InputState state;
+  };
+
+  std::vector<Entry> entries_;  // Sorted by tick
+};
+
+}  // namespace platformer2d
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace platformer2d {
+
+// Index of a texture in the AssetManager, issued when the texture is
+// registered and stable for the AssetManager's lifetime. Components and tiles
+// hold these so drawing never has to hash a texture name.
+using TextureHandle = uint16_t;
+constexpr TextureHandle kInvalidTexture{
+    std::numeric_limits<TextureHandle>::max()};
+
+}  // namespace platformer2d
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace platformer2d {
+
+// A whole file memory mapped read only. Pages are read in by the OS as they
+// are touched so opening is cheap however big the file is.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Returns false if the file can't be opened or is empty. sequential hints
+  // that the whole file is about to be read front to back so the OS starts
+  // reading ahead straight away.
+  bool open(const std::string& path, bool sequential = false);
+  void close();
+  bool isOpen() const { return data_ != nullptr; }
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const uint8_t* data_{nullptr};
+  size_t size_{0};
+};
+
+}  // namespace platformer2d
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace platformer2d {
+
+// Log linear histogram in the style of HdrHistogram. Values below
+// kHistogramSubBuckets get a bucket each, above that every power of two is
+// split into kHistogramSubBuckets / 2 buckets, so any recorded value is
+// known to within 1/64 (about 1.6%). Recording is a bit scan and an
+// increment, no allocation and no search.
+constexpr uint32_t kHistogramSubBucketBits{7};
+constexpr uint64_t kHistogramSubBuckets{1 << kHistogramSubBucketBits};
+// Values from 2^kHistogramMaxBits up all land in the last bucket
+constexpr uint32_t kHistogramMaxBits{40};
+constexpr size_t kHistogramBuckets{
+    kHistogramSubBuckets +
+    (kHistogramMaxBits - kHistogramSubBucketBits) * kHistogramSubBuckets / 2};
+
+class Histogram {
+ public:
+  Histogram() = default;
+
+  void record(uint64_t value) {
+    ++counts_[getBucket(value)];
+    ++count_;
+    sum_ += value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+  void reset();
+
+  uint64_t getCount() const { return count_; }
+  uint64_t getMin() const { return count_ == 0 ? 0 : min_; }
+  uint64_t getMax() const { return max_; }
+  // Smallest recorded value at or above the given fraction of the values,
+  // 0.99 for p99. Exact to the bucket width and never above getMax().
+  uint64_t getPercentile(double fraction) const;
+  double getMean() const { return count_ == 0 ? 0 : (double)sum_ / count_; }
+
+ private:
+  static size_t getBucket(uint64_t value) {
+    if (value < kHistogramSubBuckets) {
+      return value;
+    }
+    // Keep the top kHistogramSubBucketBits bits of the value
+    const uint32_t shift = std::min<uint32_t>(
+        std::bit_width(value) - kHistogramSubBucketBits,
+        kHistogramMaxBits - kHistogramSubBucketBits);
+    const uint64_t sub_bucket = std::min<uint64_t>(
+        value >> shift, kHistogramSubBuckets - 1);
+    return kHistogramSubBuckets + (shift - 1) * kHistogramSubBuckets / 2 +
+           (sub_bucket - kHistogramSubBuckets / 2);
+  }
+  // Largest value that lands in the bucket
+  static uint64_t getBucketHighest(size_t bucket);
+
+  std::array<uint32_t, kHistogramBuckets> counts_{};
+  uint64_t count_{0};
+  uint64_t sum_{0};
+  uint64_t min_{std::numeric_limits<uint64_t>::max()};
+  uint64_t max_{0};
+};
+
+}  // namespace platformer2d
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "constants.h"
+#include "metrics/histogram.h"
+
+namespace platformer2d {
+
+// Frames per window, histograms start over after each
+constexpr uint64_t kMetricsWindowFrames{kTargetFPS * 5};
+
+// A running total, e.g. ticks simulated
+class Counter {
+ public:
+  void add(uint64_t amount = 1) { value_ += amount; }
+  uint64_t getValue() const { return value_; }
+
+ private:
+  uint64_t value_{0};
+};
+
+// The latest value of something, e.g. entities alive
+class Gauge {
+ public:
+  void set(double value) { value_ = value; }
+  double getValue() const { return value_; }
+
+ private:
+  double value_{0};
+};
+
+// One metric at the end of a window. Counters and gauges only fill value,
+// histograms fill everything with value as the mean.
+struct MetricSnapshot {
+  std::string name;
+  const char* type;
+  double value{0};
+  uint64_t count{0};
+  uint64_t p50{0};
+  uint64_t p95{0};
+  uint64_t p99{0};
+  uint64_t max{0};
+};
+
+// Metrics are registered once and recorded through the returned reference,
+// so recording is a couple of adds with no lookup or lock. Every
+// kMetricsWindowFrames frames the window is summarised, appended to the dump
+// file if one is open and the histograms start over.
+//
+// Not thread safe, record only from the thread that calls endFrame.
+class MetricsRegistry {
+ public:
+  MetricsRegistry() = default;
+  // Dumps the window in progress too
+  ~MetricsRegistry();
+
+  MetricsRegistry(const MetricsRegistry&) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+  // References stay valid for the registry's lifetime
+  Counter& addCounter(const std::string& name);
+  Gauge& addGauge(const std::string& name);
+  Histogram& addHistogram(const std::string& name);
+
+  // Write every window to path as CSV, replacing the file. Returns false if
+  // it could not be opened.
+  bool openDump(const std::string& path);
+
+  void endFrame();
+  // Summary of the last finished window, empty before the first
+  const std::vector<MetricSnapshot>& getLastWindow() const {
+    return last_window_;
+  }
+
+ private:
+  template <typename T>
+  struct NamedMetric {
+    std::string name;
+    std::unique_ptr<T> metric;
+  };
+
+  void finishWindow();
+
+  std::vector<NamedMetric<Counter>> counters_;
+  std::vector<NamedMetric<Gauge>> gauges_;
+  std::vector<NamedMetric<Histogram>> histograms_;
+  uint64_t frame_{0};
+  uint64_t window_{0};
+  std::vector<MetricSnapshot> last_window_;
+  std::ofstream dump_;
+};
+
+}  // namespace platformer2d
@@ -0,0 +1,109 @@
+#pragma once
+
+// Counts every heap allocation, compiled in when
+// PLATFORMER2D_TRACK_ALLOCATIONS is defined (the CMake option of the same
+// name, which needs PLATFORMER2D_PROFILE). The global operator new and
+// delete are replaced and each allocation is charged to the innermost
+// PROFILE_SCOPE open on the allocating thread, so the report names the
+// system that allocated.
+
+#ifdef PLATFORMER2D_TRACK_ALLOCATIONS
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace platformer2d {
+
+// Threads that can allocate at once, more are charged to a shared slot
+constexpr size_t kMaxAllocationThreads{64};
+// Distinct zones counted per thread, more are charged to "other zones"
+constexpr size_t kMaxAllocationZones{64};
+
+// Allocations charged to one zone
+struct AllocationSite {
+  std::string_view zone;
+  uint64_t count{0};
+  uint64_t bytes{0};
+};
+
+// Totals between two endFrame calls, sites most allocations first
+struct AllocationFrame {
+  uint64_t count{0};
+  uint64_t bytes{0};
+  uint64_t frees{0};
+  std::vector<AllocationSite> sites;
+};
+
+// Allocating threads only bump relaxed atomics in a slot of their own, no
+// locks and no allocation of its own. endFrame (on the thread running
+// Game::update) reads every slot and diffs it against the previous read.
+class AllocationTracker {
+ public:
+  static AllocationTracker& get();
+
+  AllocationTracker(const AllocationTracker&) = delete;
+  AllocationTracker& operator=(const AllocationTracker&) = delete;
+
+  // Called from the replaced operator new and delete
+  void recordAllocation(size_t bytes);
+  void recordFree();
+
+  // Close the current frame, collecting what every thread allocated in it
+  void endFrame();
+  const AllocationFrame& getLastFrame() const { return last_frame_; }
+
+  // Every frame's allocation count in order, for steady state checks
+  const std::vector<uint64_t>& getFrameCounts() const { return frame_counts_; }
+  // Sites over every frame so far, most allocations first
+  const std::vector<AllocationSite>& getTotalSites() const { return totals_; }
+
+ private:
+  struct ZoneCounter {
+    std::atomic<const char*> zone{nullptr};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> bytes{0};
+  };
+
+  // Counters only ever grow so a reused slot keeps its totals
+  struct ThreadSlot {
+    std::atomic<bool> in_use{false};
+    std::atomic<uint64_t> frees{0};
+    // The last counter takes zones that didn't fit
+    std::array<ZoneCounter, kMaxAllocationZones> zones;
+  };
+
+  using SlotCounts = std::array<uint64_t, kMaxAllocationZones>;
+
+  // Hands a slot back when its thread exits
+  struct SlotOwner;
+
+  AllocationTracker() = default;
+
+  ThreadSlot& getThreadSlot();
+  ZoneCounter& getZoneCounter(ThreadSlot& slot, const char* zone);
+
+  std::array<ThreadSlot, kMaxAllocationThreads> slots_;
+  // Shared by threads that found every slot taken
+  ThreadSlot overflow_slot_;
+
+  // Counter values at the last endFrame, the overflow slot last. Only
+  // touched by endFrame.
+  std::array<SlotCounts, kMaxAllocationThreads + 1> seen_counts_{};
+  std::array<SlotCounts, kMaxAllocationThreads + 1> seen_bytes_{};
+  std::array<uint64_t, kMaxAllocationThreads + 1> seen_frees_{};
+  AllocationFrame last_frame_;
+  std::vector<uint64_t> frame_counts_;
+  std::vector<AllocationSite> totals_;
+
+  static thread_local ThreadSlot* thread_slot_;
+  // Set while the tracker itself allocates so that isn't counted
+  static thread_local bool is_internal_;
+};
+
+}  // namespace platformer2d
+
+#endif
@@ -0,0 +1,165 @@
+#pragma once
+
+// Scoped profiling zones, compiled in when PLATFORMER2D_PROFILE is defined
+// (the PLATFORMER2D_PROFILE CMake option, on by default outside Release).
+// Without it every macro below expands to nothing and none of the profiler
+// is built, so instrumented code costs nothing.
+//
+//   void PhysicsSystem::update(float delta_time) {
+//     PROFILE_SCOPE("PhysicsSystem::update");
+//     ...
+//   }
+//
+// Zone names must be string literals, only the pointer is kept.
+
+#ifdef PLATFORMER2D_PROFILE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "render/render_command_list.h"
+#include "threading/spsc_queue.h"
+
+namespace platformer2d {
+
+// Frames kept for the overlay
+constexpr size_t kProfileHistoryFrames{120};
+// Zones a thread can record between two endFrame calls before dropping them
+constexpr size_t kProfileZonesPerThread{4096};
+// Upper bound on one capture so leaving it running can't eat all memory
+constexpr size_t kMaxCapturedZones{1 << 20};
+
+struct ProfileZone {
+  const char* name;
+  uint64_t start_ns;
+  uint64_t end_ns;
+  uint32_t thread_id;
+};
+
+// Everything drained at one endFrame call
+struct ProfileFrame {
+  uint64_t start_ns{0};
+  uint64_t end_ns{0};
+  std::vector<ProfileZone> zones;
+  size_t dropped{0};
+};
+
+// Each thread records into its own lock free ring so recording a zone never
+// takes a lock or touches memory shared with another producer. Whoever calls
+// endFrame (the thread running Game::update) is the only consumer and moves
+// the zones of every thread into the frame history.
+class Profiler {
+ public:
+  static Profiler& get();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  // Name the calling thread in the overlay and exported traces
+  void setThreadName(const std::string& name);
+
+  // Record a finished zone on the calling thread
+  void record(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+  // Close the current frame, collecting every thread's zones into it
+  void endFrame();
+
+  // Keep every zone from now on until stopCapture writes them out as Chrome
+  // trace event JSON (chrome://tracing or ui.perfetto.dev). Returns false if
+  // the file could not be written.
+  void startCapture();
+  bool stopCapture(const std::string& path);
+  bool isCapturing() const { return capturing_; }
+
+  // Frame time graph and the most expensive zones of the last frames
+  void drawOverlay(RenderCommandList& commands) const;
+
+  static uint64_t now();
+
+  // Innermost zone open on the calling thread, nullptr outside any zone
+  static const char* getCurrentZone() { return current_zone_; }
+
+ private:
+  struct ThreadBuffer {
+    SpscQueue<ProfileZone, kProfileZonesPerThread> zones;
+    std::atomic<size_t> dropped{0};
+    uint32_t thread_id{0};
+    // False once the thread exits so the buffer can go to a new thread
+    bool in_use{false};
+  };
+
+  // Hands the calling thread's buffer back when the thread exits
+  struct ThreadSlot;
+
+  Profiler();
+
+  ThreadBuffer& getThreadBuffer();
+  ThreadBuffer& registerThread();
+  void releaseThread(ThreadBuffer& buffer);
+  void drain(ProfileFrame& frame);
+
+  // Guards the buffer list and thread names, taken only when a thread first
+  // records or exits and when draining, never per zone
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+  std::vector<std::string> thread_names_;  // By thread id
+
+  uint64_t epoch_ns_;
+  uint64_t frame_start_ns_;
+  // Ring of finished frames, next_frame_ is where the next one goes
+  std::vector<ProfileFrame> history_;
+  size_t next_frame_{0};
+  size_t num_frames_{0};
+
+  bool capturing_{false};
+  std::vector<ProfileZone> captured_;
+
+  // The calling thread's buffer, set on its first zone
+  static thread_local ThreadBuffer* thread_buffer_;
+  inline static thread_local const char* current_zone_{nullptr};
+
+  friend class ProfileScope;
+};
+
+// Records the time from construction to destruction as one zone
+class ProfileScope {
+ public:
+  explicit ProfileScope(const char* name)
+      : name_(name), parent_(Profiler::current_zone_) {
+    Profiler::current_zone_ = name;
+    start_ns_ = Profiler::now();
+  }
+  ~ProfileScope() {
+    Profiler::get().record(name_, start_ns_, Profiler::now());
+    Profiler::current_zone_ = parent_;
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  const char* name_;
+  const char* parent_;
+  uint64_t start_ns_;
+};
+
+}  // namespace platformer2d
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) \
+  ::platformer2d::ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__) { name }
+#define PROFILE_THREAD_NAME(name) \
+  ::platformer2d::Profiler::get().setThreadName(name)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#include "render/render_backend.h"
+
+namespace platformer2d {
+
+struct RenderStats {
+  uint64_t frames{0};
+  uint64_t commands{0};
+  std::array<uint64_t, kNumRenderCommandTypes> commands_by_type{};
+};
+
+// Backend that never touches the GPU. It counts what it is given and, if a
+// stream is provided, writes one line per command so frames can be diffed.
+class NullRenderBackend : public RenderBackend {
+ public:
+  // record_stream is optional and must outlive the backend
+  explicit NullRenderBackend(std::ostream* record_stream = nullptr);
+  void submit(const RenderCommandList& commands) override;
+
+  const RenderStats& getStats() const { return stats_; }
+
+ private:
+  std::ostream* record_stream_;
+  RenderStats stats_;
+
+  void record(const RenderCommandList& commands,
+              const RenderCommand& command) const;
+};
+
+}  // namespace platformer2d
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "render/render_backend.h"
+
+namespace platformer2d {
+
+// Draws the command list to the raylib window. Requires InitWindow to have
+// been called.
+class RaylibRenderBackend : public RenderBackend {
+ public:
+  RaylibRenderBackend() = default;
+  void submit(const RenderCommandList& commands) override;
+};
+
+}  // namespace platformer2d
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "render/render_command_list.h"
+
+namespace platformer2d {
+
+// Interface for anything that can consume a frame worth of render commands.
+// Swapping the backend lets the same frame be drawn to a window, counted
+// or recorded without a GPU context.
+class RenderBackend {
+ public:
+  RenderBackend() = default;
+  virtual ~RenderBackend() = default;
+
+  RenderBackend(const RenderBackend&) = delete;
+  RenderBackend& operator=(const RenderBackend&) = delete;
+  RenderBackend(RenderBackend&&) = delete;
+  RenderBackend& operator=(RenderBackend&&) = delete;
+
+  // Consume one full frame of commands
+  virtual void submit(const RenderCommandList& commands) = 0;
+};
+
+}  // namespace platformer2d
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "raylib.h"
+
+namespace platformer2d {
+
+enum class RenderCommandType : uint8_t {
+  kClear,
+  kTexture,
+  kTexturePro,
+  kText,
+  kLine,
+  kRectangle,
+  kBeginCamera,
+  kEndCamera,
+};
+
+constexpr size_t kNumRenderCommandTypes{8};
+
+// A single recorded draw call. Which fields are meaningful depends on type:
+// kClear       color
+// kTexture     texture, dest.x/dest.y, color (tint)
+// kTexturePro  texture, source, dest, color (tint)
+// kText        dest.x/dest.y, dest.height (font size), text, color
+// kLine        start, end, thickness, color
+// kRectangle   dest, color (filled)
+// kBeginCamera start (target), end (offset), thickness (zoom). Everything up
+//              to the next kEndCamera is in world coordinates.
+// kEndCamera   nothing, back to screen coordinates
+struct RenderCommand {
+  RenderCommandType type;
+  Color color;
+  Texture2D texture;
+  Rectangle source;
+  Rectangle dest;
+  Vector2 start;
+  Vector2 end;
+  float thickness;
+  uint32_t text_offset;  // Offset into the owning list's text buffer
+};
+
+// Systems and scenes record their draw calls into a RenderCommandList
+// instead of calling raylib directly. A RenderBackend then consumes the list.
+// The list is meant to be reused frame to frame: clear() keeps the capacity of
+// both the command and text buffers so steady state frames do not allocate.
+class RenderCommandList {
+ public:
+  RenderCommandList() = default;
+
+  void clear();
+
+  void clearBackground(Color color);
+  void drawTexture(const Texture2D& texture, float x, float y, Color tint);
+  void drawTexturePro(const Texture2D& texture, Rectangle source,
+                      Rectangle dest, Color tint);
+  void drawText(std::string_view text, int x, int y, int font_size,
+                Color color);
+  void drawLine(Vector2 start, Vector2 end, float thickness, Color color);
+  void drawRectangle(Rectangle rectangle, Color color);
+  void beginCamera(const Camera2D& camera);
+  void endCamera();
+
+  const std::vector<RenderCommand>& getCommands() const { return commands_; }
+
+  size_t size() const { return commands_.size(); }
+
+  // Null terminated text for a kText command
+  const char* getText(const RenderCommand& command) const;
+
+ private:
+  std::vector<RenderCommand> commands_;
+  std::string text_buffer_;
+};
+
+}  // namespace platformer2d
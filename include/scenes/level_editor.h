@@ -1,31 +1,69 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
+
+#include "level_editor/level_saver.h"
 #include "level_editor/tile_map.h"
 #include "level_editor/tile_picker.h"
 #include "managers/asset_manager.h"
 #include "managers/input_manager.h"
+#include "raylib.h"
 #include "scenes/scene.h"
 
 namespace platformer2d {
 
+// What a click on the map does. Rectangle and copy take two clicks, one on
+// each corner.
+enum class EditorTool : uint8_t {
+  kPaint,
+  kRectangle,
+  kFloodFill,
+  kCopy,
+  kPaste,
+};
+
 class LevelEditor : public Scene {
  public:
   LevelEditor(AssetManager& asset_manager, InputManager& input_manager);
 
   void init() override;
-  void update() override;
-  void draw() const override;
+  void update(float delta_time) override;
+  void draw(RenderCommandList& commands) const override;
+  // Waits for the level to be written so the level scene loads the edits
+  void onExit() override;
 
-  // Save current level state to disk
-  void save() const;
+  // Save current level state to disk in the background
+  void save();
 
  private:
   TileMap tile_map_;
   TilePicker tile_picker_;
+  LevelSaver saver_;
+  // Simulated seconds since the last save
+  float since_save_{0};
+  // The part of the map shown left of the tile picker. Target is the world
+  // position at the viewport's top left corner.
+  Camera2D camera_{Vector2{0, 0}, Vector2{0, 0}, 0.0f, 1.0f};
+  EditorTool tool_{EditorTool::kPaint};
+  struct Cell {
+    size_t x;
+    size_t y;
+  };
+  // First corner of a rectangle or copy waiting for the second click
+  std::optional<Cell> corner_;
+  TileRegion clipboard_;
 
   // Private methods
   void handleInput() override;
-  void drawTileMap() const;
+  // Uses the current tool on the clicked cell
+  void applyTool(size_t tile_x, size_t tile_y);
+  // Pans with the arrow keys and zooms with the mouse wheel
+  void moveCamera(float delta_time);
+  // Keeps the viewport on the map where it fits
+  void clampCamera();
+  // The world rectangle the viewport shows
+  Rectangle getView() const;
 };
 
 }  // namespace platformer2d
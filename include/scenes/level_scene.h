@@ -1,13 +1,19 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "components/animation_component.h"
 #include "components/collision_component.h"
 #include "components/movement_component.h"
 #include "components/position_component.h"
 #include "components/render_component.h"
+#include "level/baked_level.h"
+#include "level/level_streamer.h"
+#include "managers/animation_library.h"
 #include "managers/asset_manager.h"
 #include "managers/input_manager.h"
 #include "scenes/scene.h"
@@ -20,16 +26,55 @@ namespace platformer2d {
 
 class LevelScene : public Scene {
  public:
-  LevelScene(AssetManager& asset_manager, InputManager& input_manager);
-  void draw() const override;
-  void update() override;
+  LevelScene(AssetManager& asset_manager, InputManager& input_manager,
+             const AnimationLibrary& animation_library);
+  void draw(RenderCommandList& commands) const override;
+  void update(float delta_time) override;
   void init() override;
+  void onFileChanged(const std::string& path) override;
+  SceneStats getStats() const override;
 
  private:
+  // A tile as the level file describes it
+  struct LevelTile {
+    std::string texture_name;
+    float x;
+    float y;
+  };
+
   void handleInput() override;
-  void processRendering() const;
   void initPlayer();
-  void loadLevelFromFile();
+  // Brings the tile entities in line with the level file, only touching
+  // tiles that differ from the last load. Returns the number changed.
+  size_t loadLevelFromFile();
+  // Make the tile at grid cell x, y match the file, returns 1 if it changed
+  size_t syncTile(size_t x, size_t y, std::string_view texture_name,
+                  float pos_x, float pos_y,
+                  std::unordered_set<std::string>& in_file);
+  void addTile(const std::string& tag, const LevelTile& tile);
+  void removeTile(const std::string& tag);
+  // Keeps the streamed chunks around the player in step. Entities are made
+  // or dropped for at most one chunk each update so no frame does it all.
+  void streamLevel();
+  // Make a chunk's static tile entities match the chunk, returns the number
+  // changed
+  size_t applyChunk(const LevelChunk& chunk);
+  // Returns the number of tiles removed
+  size_t unloadChunk(const LevelChunkCoord& coord);
+  // Opens the baked level if it is current and matches the textures
+  bool openBakedLevel();
+  // Creates the baked level's moving tiles and the collider entities of the
+  // chunks around the player, returns the number of entities changed
+  size_t addBakedLevel(std::unordered_set<std::string>& in_file);
+  // Keeps the baked chunks with collider entities around the focus in step,
+  // returns the number of entities changed
+  size_t updateBakedChunks(float focus_x, float focus_y);
+  // Both return the number of colliders added or removed
+  size_t addBakedChunk(const LevelChunkCoord& coord);
+  size_t removeBakedChunk(const LevelChunkCoord& coord);
+  size_t removeBakedColliders();
+
+  const AnimationLibrary& animation_library_;
 
   // Owned systems
   PhysicsSystem physics_;
@@ -43,6 +88,21 @@ class LevelScene : public Scene {
   std::unordered_map<std::string, MovementComponent> movement_components_;
   std::unordered_map<std::string, RenderComponent> render_components_;
   std::unordered_map<std::string, AnimationComponent> animation_components_;
+
+  // Tiles from the last load by entity tag
+  std::unordered_map<std::string, LevelTile> level_tiles_;
+
+  // Open while the level comes from the baked format. Its static tiles are
+  // drawn straight from the mapped draw lists and have no entities, only
+  // the merged colliders of the chunks around the player do.
+  BakedLevel baked_;
+  ChunkWindow baked_chunks_;
+  // Open while the level comes from the binary format
+  LevelStreamer streamer_;
+  // Tile tags of each streamed in chunk by chunk key. Moving tiles belong
+  // to no chunk and stay loaded until the level is.
+  std::unordered_map<uint64_t, std::vector<std::string>> chunk_tiles_;
+  std::vector<LevelChunkCoord> chunks_to_unload_;
 };
 
 }  // namespace platformer2d
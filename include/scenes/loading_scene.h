@@ -0,0 +1,26 @@
+#pragma once
+
+#include "managers/asset_manager.h"
+#include "managers/input_manager.h"
+#include "scenes/scene.h"
+
+namespace platformer2d {
+
+// Shown while the textures a scene acquired are still streaming in. Each
+// update uploads whatever the asset workers have decoded, within a per frame
+// time budget, and draw shows how far along loading is.
+class LoadingScene : public Scene {
+ public:
+  LoadingScene(AssetManager& asset_manager, InputManager& input_manager);
+
+  void init() override;
+  void update(float delta_time) override;
+  void draw(RenderCommandList& commands) const override;
+
+  bool isDone() const;
+
+ private:
+  void handleInput() override;
+};
+
+}  // namespace platformer2d
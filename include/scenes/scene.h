@@ -1,11 +1,23 @@
 #pragma once
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "managers/asset_manager.h"
 #include "managers/input_manager.h"
 #include "raylib.h"
+#include "render/render_command_list.h"
 
 namespace platformer2d {
 
+// What a scene has running, for metrics
+struct SceneStats {
+  size_t entities{0};
+  size_t colliders{0};
+  size_t collision_pairs{0};
+};
+
 class Scene {
  public:
   Scene(std::string name, Color color, AssetManager& asset_manager,
@@ -15,10 +27,23 @@ class Scene {
         asset_manager_(asset_manager),
         input_manager_(input_manager) {}
 
-  virtual ~Scene() = default;
-  virtual void update() = 0;
-  virtual void draw() const = 0;
+  // Give back everything the scene acquired
+  virtual ~Scene() {
+    for (TextureHandle texture : acquired_textures_) {
+      asset_manager_.releaseTexture(texture);
+    }
+  }
+
+  // delta_time is the simulated time in seconds since the last update
+  virtual void update(float delta_time) = 0;
+  virtual void draw(RenderCommandList& commands) const = 0;
   virtual void init() = 0;
+  // The scene is being replaced. Runs before the next scene's init() so
+  // anything that scene reads back is finished.
+  virtual void onExit() {}
+  // A file the scene may depend on changed on disk while it was running
+  virtual void onFileChanged(const std::string& /*path*/) {}
+  virtual SceneStats getStats() const { return SceneStats{}; }
 
   // Getter for name
   std::string name() const { return name_; }
@@ -30,6 +55,21 @@ class Scene {
   InputManager& input_manager_;
 
   virtual void handleInput() = 0;  // Moved from private to protected
+
+  // Keep a texture resident for the lifetime of this scene. Acquire
+  // everything the scene draws in init() so it loads in the background.
+  // Acquiring a texture the scene already holds does nothing.
+  void acquireTexture(TextureHandle texture) {
+    if (std::find(acquired_textures_.begin(), acquired_textures_.end(),
+                  texture) != acquired_textures_.end()) {
+      return;
+    }
+    asset_manager_.acquireTexture(texture);
+    acquired_textures_.push_back(texture);
+  }
+
+ private:
+  std::vector<TextureHandle> acquired_textures_;
 };
 
 }  // namespace platformer2d
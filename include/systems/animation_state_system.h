@@ -1,24 +1,47 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "components/animation_component.h"
 #include "components/movement_component.h"
+#include "managers/animation_library.h"
 
 namespace platformer2d {
 
+struct AnimatedMoverAggregate {
+  AnimationComponent& animation;
+  const MovementComponent& movement;
+
+  AnimatedMoverAggregate(AnimationComponent& anim,
+                         const MovementComponent& move)
+      : animation{anim}, movement{move} {}
+};
+
+// Steps every entity's animation state machine. Works in two batched passes:
+// first the condition bits for all entities are gathered from their movement,
+// then each entity's current state's transitions are scanned in the
+// library's tables. No per-type code is needed to animate new characters.
 class AnimationStateSystem {
  public:
   AnimationStateSystem(
       std::unordered_map<std::string, AnimationComponent>& animations,
-      std::unordered_map<std::string, MovementComponent>& movements);
+      std::unordered_map<std::string, MovementComponent>& movements,
+      const AnimationLibrary& library);
 
+  // Gather the components of every animated entity. Call after the
+  // entities have been created.
+  void init();
   void update();
 
  private:
   std::unordered_map<std::string, AnimationComponent>& animations_;
   std::unordered_map<std::string, MovementComponent>& movements_;
+  const AnimationLibrary& library_;
+  std::vector<AnimatedMoverAggregate> movers_;
+  std::vector<uint8_t> conditions_;  // One entry per mover, reused per update
 };
 
-}  // namespace platformer2d
\ No newline at end of file
+}  // namespace platformer2d
@@ -1,30 +1,48 @@
 #pragma once
 
 #include <unordered_map>
+#include <vector>
 
 #include "components/animation_component.h"
 #include "components/movement_component.h"
 #include "components/position_component.h"
+#include "managers/animation_library.h"
 #include "managers/asset_manager.h"
+#include "render/render_command_list.h"
 
 namespace platformer2d {
 
+struct SpriteComponentAggregate {
+  AnimationComponent& animation;
+  const PositionComponent& position;
+  const MovementComponent& movement;
+
+  SpriteComponentAggregate(AnimationComponent& anim,
+                           const PositionComponent& pos,
+                           const MovementComponent& move)
+      : animation{anim}, position{pos}, movement{move} {}
+};
+
 class AnimationSystem {
  public:
   AnimationSystem(
       std::unordered_map<std::string, AnimationComponent>& animations,
       std::unordered_map<std::string, PositionComponent>& positions,
       std::unordered_map<std::string, MovementComponent>& movements,
-      AssetManager& assets);
-  void update();
-  void draw() const;
+      const AnimationLibrary& library, AssetManager& assets);
+  // Gather the components of every animated entity. Call after the
+  // entities have been created.
+  void init();
+  void update(float delta_time);
+  void draw(RenderCommandList& commands) const;
 
  private:
   std::unordered_map<std::string, AnimationComponent>& animations_;
   std::unordered_map<std::string, PositionComponent>& positions_;
   std::unordered_map<std::string, MovementComponent>& movements_;
+  const AnimationLibrary& library_;
   AssetManager& assets_;
-  int frame_number_;
+  std::vector<SpriteComponentAggregate> sprites_;
 };
 
-}  // namespace platformer2d
\ No newline at end of file
+}  // namespace platformer2d
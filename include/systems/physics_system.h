@@ -35,24 +35,35 @@ struct CollisionPair {
   Vector2 mtv;
 };
 
+struct PhysicsStats {
+  size_t movers{0};
+  size_t colliders{0};
+  // Overlaps resolved in the last update
+  size_t collision_pairs{0};
+};
+
 class PhysicsSystem {
  public:
   PhysicsSystem() = default;
+  // Gather the components of every entity. Call again whenever entities are
+  // added or removed.
   void init(
       std::unordered_map<std::string, MovementComponent>& movement_components,
       std::unordered_map<std::string, PositionComponent>& position_components,
       std::unordered_map<std::string, CollisionComponent>&
           collision_components);
-  void update();
+  void update(float delta_time);
+  const PhysicsStats& getStats() const { return stats_; }
 
  private:
+  PhysicsStats stats_;
   std::vector<MoverComponentAggregate> mover_components_;
   std::vector<ColliderComponentAggregate> collider_components_;
 
   std::vector<CollisionPair> calculateCollisions(
       MoverComponentAggregate& mover);
   void resolveCollisions(std::vector<CollisionPair>& collisions);
-  void updateVelocity(MoverComponentAggregate& mover);
+  void updateVelocity(MoverComponentAggregate& mover, float delta_time);
   void updatePosition(MoverComponentAggregate& mover);
 
   static void updateVelocityY(MovementComponent& movement, float delta_time);
@@ -6,6 +6,7 @@
 #include "components/position_component.h"
 #include "components/render_component.h"
 #include "managers/asset_manager.h"
+#include "render/render_command_list.h"
 
 namespace platformer2d {
 
@@ -15,7 +16,7 @@ class RenderSystem {
       std::unordered_map<std::string, PositionComponent>& position_components,
       std::unordered_map<std::string, RenderComponent>& render_components,
       AssetManager& assets);
-  void draw() const;
+  void draw(RenderCommandList& commands) const;
 
  private:
   std::unordered_map<std::string, PositionComponent>& position_components_;
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace platformer2d {
+
+// Lock free single producer / single consumer triple buffer.
+//
+// The producer always owns one slot (back), the consumer always owns one slot
+// (front) and the third slot (middle) is handed between them with a single
+// atomic exchange. The producer never waits on the consumer and the consumer
+// always sees the most recently published value, skipping older ones.
+template <typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() = default;
+
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+  TripleBuffer(TripleBuffer&&) = delete;
+  TripleBuffer& operator=(TripleBuffer&&) = delete;
+
+  // Producer side: fill this then publish()
+  T& getWriteBuffer() { return buffers_[back_]; }
+
+  void publish() {
+    const uint8_t previous =
+        middle_.exchange(back_ | kNewBit, std::memory_order_acq_rel);
+    back_ = previous & kIndexMask;
+  }
+
+  // Consumer side: swap in the latest published value if there is one.
+  // Returns true if getReadBuffer() changed.
+  bool acquireLatest() {
+    if ((middle_.load(std::memory_order_relaxed) & kNewBit) == 0) {
+      return false;
+    }
+    const uint8_t previous =
+        middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = previous & kIndexMask;
+    return true;
+  }
+
+  const T& getReadBuffer() const { return buffers_[front_]; }
+
+ private:
+  static constexpr uint8_t kIndexMask{0x3};
+  static constexpr uint8_t kNewBit{0x4};
+
+  std::array<T, 3> buffers_{};
+  // Each side's index on its own cache line so they do not false share
+  alignas(64) uint8_t back_{0};
+  alignas(64) std::atomic<uint8_t> middle_{1};
+  alignas(64) uint8_t front_{2};
+};
+
+}  // namespace platformer2d
@@ -0,0 +1,37 @@
+#include "atomic_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+
+#include "debug.h"
+
+namespace platformer2d {
+
+bool writeFileAtomic(const std::string& path, std::string_view contents) {
+  const std::string temp_path{path + ".tmp"};
+  const int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_ERROR("Failed to create " << temp_path);
+    return false;
+  }
+  bool written{true};
+  for (size_t offset = 0; written && offset < contents.size();) {
+    const ssize_t count =
+        ::write(fd, contents.data() + offset, contents.size() - offset);
+    written = count > 0;
+    offset += written ? count : 0;
+  }
+  // The data has to be on disk before the rename makes it the real file
+  written = written && fsync(fd) == 0;
+  written = ::close(fd) == 0 && written;
+  if (!written || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    LOG_ERROR("Failed to write " << path);
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace platformer2d
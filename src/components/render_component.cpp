@@ -5,7 +5,7 @@
 namespace platformer2d {
 
 RenderComponent::RenderComponent(const std::string& tag,
-                                 const std::string& texture_name)
-    : Component(tag), texture_name(texture_name) {}
+                                 TextureHandle texture)
+    : Component(tag), texture(texture) {}
 
 }  // namespace platformer2d
\ No newline at end of file
@@ -1,8 +1,15 @@
 #include "game.h"
 
 #include "constants.h"
+#include "debug.h"
 #include "raylib.h"
+#include "render/null_render_backend.h"
+#include "render/raylib_render_backend.h"
+#include "managers/asset_manifest.h"
+#include "profiling/allocation_tracker.h"
+#include "profiling/profiler.h"
 #include "scenes/level_scene.h"
+#include "scenes/loading_scene.h"
 
 // Level editor should only be in non Release builds keep the binary
 // smaller buy not compiling it in
@@ -15,68 +22,170 @@ namespace platformer2d {
 // Forward declare free helper function
 void initWindow();
 void resizeWindow(const int width, const int height);
+uint64_t getNanosecondsSince(std::chrono::steady_clock::time_point start);
 
-// just declare a static array of tuple which has all Tiles in (name, file_name)
-// pairs maybe later will dynamicall load textures based on paths like
-// assets/tiles and assets/sprites. Doing it this way for now until I have a
-// better idea what is best
-constexpr int num_textures{18};
-using TextureNameFile =
-    const std::array<std::tuple<std::string, std::string>, num_textures>;
-TextureNameFile texture_name_to_file{
-    std::tuple{"tile_winter_ground_0", "assets/winter_ground/ground0.png"},
-    std::tuple{"tile_winter_ground_1", "assets/winter_ground/ground1.png"},
-    std::tuple{"tile_winter_ground_2", "assets/winter_ground/ground2.png"},
-    std::tuple{"tile_winter_ground_3", "assets/winter_ground/ground3.png"},
-    std::tuple{"tile_winter_ground_4", "assets/winter_ground/ground4.png"},
-    std::tuple{"tile_winter_ground_5", "assets/winter_ground/ground5.png"},
-    std::tuple{"tile_winter_ground_6", "assets/winter_ground/ground6.png"},
-    std::tuple{"tile_winter_ground_7", "assets/winter_ground/ground7.png"},
-    std::tuple{"tile_winter_ground_8", "assets/winter_ground/ground8.png"},
-    std::tuple{"tile_winter_ground_9", "assets/winter_ground/ground9.png"},
-    std::tuple{"tile_winter_groundIce1", "assets/winter_ground/groundIce1.png"},
-    std::tuple{"tile_winter_groundIce2", "assets/winter_ground/groundIce2.png"},
-    std::tuple{"tile_winter_groundIce3", "assets/winter_ground/groundIce3.png"},
-    std::tuple{"tile_winter_groundl", "assets/winter_ground/groundl.png"},
-    std::tuple{"tile_winter_groundr", "assets/winter_ground/groundr.png"},
-    std::tuple{"tile_winter_ice", "assets/winter_ground/ice.png"},
-};
-
-Game::Game() : input_manager_(), asset_manager_() {
-  // Setup Window
-  initWindow();
-
-  // Load all textures
-  for (auto& pair : texture_name_to_file) {
-    asset_manager_.loadTexture(std::get<0>(pair), std::get<1>(pair), kTileSize,
-                               kTileSize);
-  }
-
-  // Load in sprites (different size than tiles)
-  asset_manager_.loadTexture("pink_monster_idle",
-                             "assets/Pink_Monster_Idle_4.png");
-  asset_manager_.loadTexture("pink_monster_run",
-                             "assets/Pink_Monster_Run_6.png");
-
-  current_scene_ = std::make_unique<LevelScene>(asset_manager_, input_manager_);
-  current_scene_->init();
-}
-
-Game::~Game() { CloseWindow(); }
-
-void Game::update() {
-  handleInput();
-  current_scene_->update();
-}
-
-void Game::draw() const {
-  BeginDrawing();
-  current_scene_->draw();
-  EndDrawing();
+constexpr char kAssetRoot[]{"assets"};
+constexpr char kAssetManifestPath[]{"assets/manifest.json"};
+constexpr char kAssetBundlePath[]{"assets/textures.bundle"};
+// Textures a scene acquires while playing upload within this each update,
+// less than the loading screen takes since the scene runs too
+constexpr double kPlayUploadBudgetSeconds{0.002};
+#ifdef PLATFORMER2D_PROFILE
+constexpr char kProfileTracePath[]{"profile_trace.json"};
+#endif
+
+Game::Game(GameMode mode)
+    : mode_(mode),
+      input_manager_(),
+      asset_manager_(mode == GameMode::kHeadless),
+      animation_library_(),
+      loading_scene_(asset_manager_, input_manager_),
+      render_commands_(),
+      window_width_(kScreenWidth),
+      window_height_(kScreenHeight),
+      frame_metrics_(metrics_) {
+  PROFILE_THREAD_NAME("main");
+  if (mode_ == GameMode::kHeadless) {
+    render_backend_ = std::make_unique<NullRenderBackend>();
+  } else {
+    // Setup Window
+    initWindow();
+    render_backend_ = std::make_unique<RaylibRenderBackend>();
+  }
+
+  // Register every asset but load nothing yet, scenes acquire what they use
+  AssetManifest manifest;
+  if (!manifest.loadFromFile(kAssetManifestPath)) {
+    DLOG("No asset manifest, scanning " << kAssetRoot);
+    manifest = AssetManifest::scan(kAssetRoot);
+  }
+  asset_manager_.registerManifest(manifest);
+  // Pre-decoded pixels if the bundle has been built, pngs otherwise
+  if (!asset_manager_.mountBundle(kAssetBundlePath)) {
+    DLOG("No asset bundle, loading textures from png");
+  }
+
+  if (mode_ == GameMode::kThreaded) {
+    // Only the main thread may touch the GPU and after this point scenes
+    // change on the simulation thread, so load and pin everything now
+    for (const auto& asset : manifest.getEntries()) {
+      asset_manager_.acquireTexture(asset_manager_.getHandle(asset.name));
+    }
+    asset_manager_.finishLoading();
+  }
+
+  // Hot reload while playing. Headless runs stay reproducible and threaded
+  // mode can't reload textures off the main thread.
+  if (mode_ == GameMode::kWindowed) {
+    file_watcher_.watchDirectory(kAssetRoot);
+  }
+
+  startLevel();
+}
+
+Game::~Game() {
+  if (mode_ != GameMode::kHeadless) {
+    CloseWindow();
+  }
+}
+
+void Game::update(float delta_time) {
+#ifdef PLATFORMER2D_PROFILE
+  // One profiler frame per update, whichever thread simulates
+  Profiler::get().endFrame();
+#endif
+#ifdef PLATFORMER2D_TRACK_ALLOCATIONS
+  AllocationTracker::get().endFrame();
+#endif
+  PROFILE_SCOPE("Game::update");
+  const auto start = std::chrono::steady_clock::now();
+  recordFrameMetrics(start);
+
+  // Windowed play shows progress while a new scene's textures stream in,
+  // other modes just block on the first getTexture
+  if (isShowingLoadingScreen()) {
+    loading_scene_.update(delta_time);
+  } else {
+    // Later batches, like a hot reload's, load while the scene keeps running
+    loading_new_scene_ = false;
+    if (mode_ == GameMode::kWindowed) {
+      reloadChangedFiles();
+    }
+    handleInput();
+    current_scene_->update(delta_time);
+    if (mode_ == GameMode::kWindowed) {
+      asset_manager_.uploadPendingTextures(kPlayUploadBudgetSeconds);
+    }
+  }
+  frame_metrics_.update_ns.record(getNanosecondsSince(start));
+}
+
+void Game::draw() {
+  // Build the frame first then hand it to the backend so building the
+  // command list can be measured separately from submission
+  PROFILE_SCOPE("Game::draw");
+  render_commands_.clear();
+  buildFrame(render_commands_);
+  const auto submit_start = std::chrono::steady_clock::now();
+  submitFrame(render_commands_);
+  frame_metrics_.submit_ns.record(getNanosecondsSince(submit_start));
+  asset_manager_.endFrame();
+}
+
+void Game::buildFrame(RenderCommandList& commands) const {
+  PROFILE_SCOPE("Game::buildFrame");
+  const auto start = std::chrono::steady_clock::now();
+  if (isShowingLoadingScreen()) {
+    loading_scene_.draw(commands);
+  } else {
+    current_scene_->draw(commands);
+  }
+#ifdef PLATFORMER2D_PROFILE
+  if (show_profiler_) {
+    Profiler::get().drawOverlay(commands);
+  }
+#endif
+  frame_metrics_.draw_ns.record(getNanosecondsSince(start));
+}
+
+void Game::submitFrame(const RenderCommandList& commands) {
+  PROFILE_SCOPE("Game::submitFrame");
+  render_backend_->submit(commands);
+}
+
+void Game::setTextureBudget(size_t bytes) {
+  // Evicted textures reload on first use, which in threaded mode would be on
+  // the simulation thread without a GL context
+  if (mode_ == GameMode::kThreaded) {
+    DLOG("Texture budget is ignored in threaded mode");
+    return;
+  }
+  asset_manager_.setMemoryBudget(bytes);
+}
+
+void Game::setRenderBackend(std::unique_ptr<RenderBackend> render_backend) {
+  render_backend_ = std::move(render_backend);
 }
 
 void Game::handleInput() {
-  input_manager_.getInput();
+  // Headless runs have their input set from outside before each update
+  if (mode_ == GameMode::kWindowed) {
+    input_manager_.getInput();
+  }
+#ifdef PLATFORMER2D_PROFILE
+  if (input_manager_.isF3Pressed()) {
+    show_profiler_ = !show_profiler_;
+  }
+  // Start a capture, or end it and write the trace
+  if (input_manager_.isF4Pressed()) {
+    Profiler& profiler = Profiler::get();
+    if (!profiler.isCapturing()) {
+      profiler.startCapture();
+    } else if (!profiler.stopCapture(kProfileTracePath)) {
+      DLOG("Failed to write " << kProfileTracePath);
+    }
+  }
+#endif
 #ifndef NDEBUG
   // Toggle editor mode
   if (input_manager_.isEPressed()) {
@@ -84,21 +193,91 @@ void Game::handleInput() {
       setCurrentScene(
           std::make_unique<LevelEditor>(asset_manager_, input_manager_));
       // Add width of tile picker to screen width
-      resizeWindow(kScreenWidth + kTilePickerWidth, kScreenHeight);
+      window_width_ = kScreenWidth + kTilePickerWidth;
     } else {
-      setCurrentScene(
-          std::make_unique<LevelScene>(asset_manager_, input_manager_));
-      resizeWindow(kScreenWidth, kScreenHeight);
+      setCurrentScene(std::make_unique<LevelScene>(
+          asset_manager_, input_manager_, animation_library_));
+      window_width_ = kScreenWidth;
+    }
+    // In threaded mode the window belongs to the main thread which resizes
+    // it from the published frame instead
+    if (mode_ == GameMode::kWindowed) {
+      resizeWindow(window_width_, window_height_);
     }
-    current_scene_->init();
   }
 #endif
 }
 
+// Closes the previous frame. Scene counts are read here rather than inside
+// the systems so recording stays off their hot loops.
+void Game::recordFrameMetrics(std::chrono::steady_clock::time_point start) {
+  if (frame_metrics_.ticks.getValue() > 0) {
+    frame_metrics_.frame_ns.record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            start - last_update_start_)
+            .count());
+  }
+  last_update_start_ = start;
+  frame_metrics_.ticks.add();
+  const SceneStats scene = current_scene_->getStats();
+  frame_metrics_.entities.set(scene.entities);
+  frame_metrics_.colliders.set(scene.colliders);
+  frame_metrics_.collision_pairs.set(scene.collision_pairs);
+  const TextureStats& textures = asset_manager_.getStats();
+  frame_metrics_.textures.set(textures.resident_textures);
+  frame_metrics_.texture_bytes.set(textures.resident_bytes);
+  metrics_.endFrame();
+}
+
+void Game::reloadChangedFiles() {
+  for (const auto& path : file_watcher_.poll()) {
+    asset_manager_.reloadFile(path);
+    current_scene_->onFileChanged(path);
+  }
+}
+
+void Game::startLevel() {
+  // Clips are compiled against the loaded textures so must come after them
+  if (!animation_library_.loadFromFile("assets/animations/clips.json",
+                                       asset_manager_) ||
+      !animation_library_.loadStateMachinesFromFile(
+          "assets/animations/state_machines.json")) {
+    PANIC("Failed to load animations");
+  }
+
+  setCurrentScene(std::make_unique<LevelScene>(asset_manager_, input_manager_,
+                                               animation_library_));
+}
+
 void Game::setCurrentScene(std::unique_ptr<Scene> new_scene) {
+  if (current_scene_) {
+    current_scene_->onExit();
+  }
+  // Init before the old scene goes so textures both use stay resident
+  new_scene->init();
+  asset_manager_.startLoading();
+  loading_new_scene_ = true;
   current_scene_ = std::move(new_scene);
+  asset_manager_.releaseUnused();
+}
+
+bool Game::isShowingLoadingScreen() const {
+  return mode_ == GameMode::kWindowed && loading_new_scene_ &&
+         !loading_scene_.isDone();
 }
 
+FrameMetrics::FrameMetrics(MetricsRegistry& registry)
+    : frame_ns(registry.addHistogram("frame_ns")),
+      update_ns(registry.addHistogram("update_ns")),
+      draw_ns(registry.addHistogram("draw_ns")),
+      submit_ns(registry.addHistogram("submit_ns")),
+      ticks(registry.addCounter("ticks")),
+      entities(registry.addGauge("entities")),
+      colliders(registry.addGauge("colliders")),
+      collision_pairs(registry.addGauge("collision_pairs")),
+      textures(registry.addGauge("textures")),
+      texture_bytes(registry.addGauge("texture_bytes")) {}
+
 void initWindow() {
   InitWindow(kScreenWidth, kScreenHeight, "2D Platform Game");
   SetTargetFPS(kTargetFPS);
@@ -108,4 +287,10 @@ void resizeWindow(const int width, const int height) {
   SetWindowSize(width, height);
 }
 
+uint64_t getNanosecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
 }  // namespace platformer2d
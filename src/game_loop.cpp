@@ -0,0 +1,184 @@
+#include "game_loop.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "debug.h"
+#include "profiling/profiler.h"
+#include "raylib.h"
+#include "render/render_command_list.h"
+#include "threading/spsc_queue.h"
+#include "threading/triple_buffer.h"
+
+namespace platformer2d {
+
+void runWindowed(Game& game) {
+  CHECK(game.getMode() == GameMode::kWindowed,
+        "runWindowed needs a windowed game");
+  while (!WindowShouldClose()) {
+    game.update(GetFrameTime());
+    game.draw();
+  }
+}
+
+// Everything the main thread needs to present one simulated frame
+struct RenderFrame {
+  RenderCommandList commands;
+  int window_width{kScreenWidth};
+  int window_height{kScreenHeight};
+};
+
+// Input polled once per presented frame and queued for the simulation
+using InputQueue = SpscQueue<InputState, 64>;
+
+// Forward declare free helpers
+InputState drainInput(InputQueue& queue, const InputState& previous);
+void simulate(Game& game, const ThreadedOptions& options,
+              InputQueue& input_queue, TripleBuffer<RenderFrame>& frames,
+              std::atomic<bool>& running);
+
+void runThreaded(Game& game, const ThreadedOptions& options) {
+  CHECK(game.getMode() == GameMode::kThreaded,
+        "runThreaded needs a threaded game");
+  // Both are large and shared between threads so keep them off the stack
+  auto input_queue = std::make_unique<InputQueue>();
+  auto frames = std::make_unique<TripleBuffer<RenderFrame>>();
+  std::atomic<bool> running{true};
+
+  std::thread simulation_thread{simulate, std::ref(game), std::cref(options),
+                                std::ref(*input_queue), std::ref(*frames),
+                                std::ref(running)};
+
+  int window_width{kScreenWidth};
+  int window_height{kScreenHeight};
+  while (!WindowShouldClose()) {
+    // If the simulation is behind just drop input rather than block
+    input_queue->tryPush(InputManager::pollInput());
+
+    frames->acquireLatest();
+    const RenderFrame& frame = frames->getReadBuffer();
+    if (frame.window_width != window_width ||
+        frame.window_height != window_height) {
+      window_width = frame.window_width;
+      window_height = frame.window_height;
+      SetWindowSize(window_width, window_height);
+    }
+    // Also polls the window's input events in EndDrawing
+    game.submitFrame(frame.commands);
+  }
+
+  running.store(false, std::memory_order_relaxed);
+  simulation_thread.join();
+}
+
+// Held keys take the newest value, presses and clicks are kept if they
+// happened in any of the queued polls so none are lost between ticks
+InputState drainInput(InputQueue& queue, const InputState& previous) {
+  InputState merged{};
+  merged.is_left = previous.is_left;
+  merged.is_right = previous.is_right;
+  merged.is_up = previous.is_up;
+  merged.is_down = previous.is_down;
+  InputState polled;
+  while (queue.tryPop(polled)) {
+    merged.is_left = polled.is_left;
+    merged.is_right = polled.is_right;
+    merged.is_up = polled.is_up;
+    merged.is_down = polled.is_down;
+    merged.is_space |= polled.is_space;
+    merged.is_e_pressed |= polled.is_e_pressed;
+    merged.is_s_pressed |= polled.is_s_pressed;
+    merged.is_t_pressed |= polled.is_t_pressed;
+    merged.mouse_wheel += polled.mouse_wheel;
+    merged.is_f3_pressed |= polled.is_f3_pressed;
+    merged.is_f4_pressed |= polled.is_f4_pressed;
+    if (polled.is_mouse_clicked) {
+      merged.is_mouse_clicked = true;
+      merged.mouse_position_x = polled.mouse_position_x;
+      merged.mouse_position_y = polled.mouse_position_y;
+    }
+  }
+  return merged;
+}
+
+void simulate(Game& game, const ThreadedOptions& options,
+              InputQueue& input_queue, TripleBuffer<RenderFrame>& frames,
+              std::atomic<bool>& running) {
+  using Clock = std::chrono::steady_clock;
+  const auto tick_duration =
+      std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<float>(kFixedTimestep));
+  auto next_tick = Clock::now();
+  InputState input{};
+  uint64_t tick{0};
+  PROFILE_THREAD_NAME("simulation");
+
+  while (running.load(std::memory_order_relaxed)) {
+    const bool replaying = options.replay_input != nullptr &&
+                           tick < options.replay_input->getTickCount();
+    // Live input still has to be drained while replaying or it piles up
+    input = drainInput(input_queue, input);
+    const InputState tick_input =
+        replaying ? options.replay_input->getInput(tick) : input;
+    if (options.record_input != nullptr) {
+      options.record_input->record(tick_input);
+    }
+    game.getInputManager().setInput(tick_input);
+    game.update(kFixedTimestep);
+    ++tick;
+
+    RenderFrame& frame = frames.getWriteBuffer();
+    frame.commands.clear();
+    game.buildFrame(frame.commands);
+    frame.window_width = game.getWindowWidth();
+    frame.window_height = game.getWindowHeight();
+    frames.publish();
+
+    // Only published frames are ever seen, most are skipped when fast
+    // forwarding
+    if (replaying && options.fast_forward) {
+      next_tick = Clock::now();
+      continue;
+    }
+    next_tick += tick_duration;
+    // If we fell far behind don't try to catch up with a burst of ticks
+    const auto now = Clock::now();
+    if (next_tick < now - tick_duration) {
+      next_tick = now;
+    }
+    std::this_thread::sleep_until(next_tick);
+  }
+}
+
+HeadlessReport runHeadless(Game& game, const HeadlessOptions& options) {
+  CHECK(game.getMode() == GameMode::kHeadless,
+        "runHeadless needs a headless game");
+  const auto start = std::chrono::steady_clock::now();
+  for (uint64_t tick = 0; tick < options.ticks; ++tick) {
+    InputState input{};
+    if (options.replay_input != nullptr) {
+      input = options.replay_input->getInput(tick);
+    } else if (options.input_script != nullptr) {
+      input = options.input_script->getInput(tick);
+    }
+    if (options.record_input != nullptr) {
+      options.record_input->record(input);
+    }
+    game.getInputManager().setInput(input);
+    game.update(options.timestep);
+    if (options.draw) {
+      game.draw();
+    }
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  HeadlessReport report;
+  report.ticks = options.ticks;
+  report.simulated_seconds = options.ticks * (double)options.timestep;
+  report.wall_seconds = elapsed.count();
+  return report;
+}
+
+}  // namespace platformer2d
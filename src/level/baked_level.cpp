@@ -0,0 +1,302 @@
+#include "level/baked_level.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "atomic_file.h"
+#include "debug.h"
+
+namespace platformer2d {
+
+constexpr char kBakedMagic[4]{'P', '2', 'L', 'K'};
+constexpr uint32_t kBakedVersion{2};
+
+// Forward declare free helpers
+void mergeColliders(const LevelData& level, const std::vector<bool>& moving,
+                    uint32_t start_x, uint32_t start_y, uint32_t end_x,
+                    uint32_t end_y, std::vector<BakedCollider>& colliders);
+template <typename T>
+void appendTable(std::string& baked, uint32_t& offset,
+                 const std::vector<T>& table);
+template <typename T>
+bool mapTable(const MappedFile& file, uint32_t offset, uint32_t count,
+              std::span<const T>& table);
+
+bool bakeLevel(const LevelData& level, const AssetManager& assets,
+               const std::string& path) {
+  std::string strings;
+  std::vector<BakedTexture> textures;
+  std::vector<TextureHandle> handles;
+  std::vector<bool> moving;
+  for (const auto& name : level.palette) {
+    const TextureHandle handle = assets.findHandle(name);
+    if (handle == kInvalidTexture) {
+      DLOG("Level uses unknown texture " << name);
+      return false;
+    }
+    textures.push_back(BakedTexture{
+        LevelFileString{static_cast<uint32_t>(strings.size()),
+                        static_cast<uint32_t>(name.size())},
+        handle, 0});
+    strings += name;
+    handles.push_back(handle);
+    moving.push_back(name == kMovingTileTexture);
+  }
+
+  std::vector<BakedChunk> chunks;
+  std::vector<BakedSprite> sprites;
+  std::vector<BakedCollider> colliders;
+  std::vector<BakedMovingTile> moving_tiles;
+  for (uint32_t start_y = 0; start_y < level.height;
+       start_y += kLevelChunkSize) {
+    for (uint32_t start_x = 0; start_x < level.width;
+         start_x += kLevelChunkSize) {
+      const uint32_t end_x = std::min(start_x + kLevelChunkSize, level.width);
+      const uint32_t end_y = std::min(start_y + kLevelChunkSize, level.height);
+      BakedChunk chunk{static_cast<int32_t>(start_x / kLevelChunkSize),
+                       static_cast<int32_t>(start_y / kLevelChunkSize),
+                       static_cast<uint32_t>(sprites.size()), 0,
+                       static_cast<uint32_t>(colliders.size()), 0};
+      for (uint32_t y = start_y; y < end_y; ++y) {
+        for (uint32_t x = start_x; x < end_x; ++x) {
+          const LevelTileId tile = level.getTile(x, y);
+          if (tile == kEmptyLevelTile) continue;
+          const float pos_x = level.origin_x + x * level.tile_size;
+          const float pos_y = level.origin_y + y * level.tile_size;
+          if (moving[tile - 1]) {
+            moving_tiles.push_back(
+                BakedMovingTile{x, y, pos_x, pos_y, handles[tile - 1], 0});
+          } else {
+            sprites.push_back(
+                BakedSprite{pos_x, pos_y, handles[tile - 1], 0});
+          }
+        }
+      }
+      mergeColliders(level, moving, start_x, start_y, end_x, end_y,
+                     colliders);
+      chunk.num_sprites = sprites.size() - chunk.first_sprite;
+      chunk.num_colliders = colliders.size() - chunk.first_collider;
+      if (chunk.num_sprites > 0 || chunk.num_colliders > 0) {
+        chunks.push_back(chunk);
+      }
+    }
+  }
+
+  BakedLevelHeader header{};
+  std::memcpy(header.magic, kBakedMagic, sizeof(kBakedMagic));
+  header.version = kBakedVersion;
+  header.num_textures = textures.size();
+  header.num_chunks = chunks.size();
+  header.num_sprites = sprites.size();
+  header.num_colliders = colliders.size();
+  header.num_moving_tiles = moving_tiles.size();
+  header.strings_size = strings.size();
+  header.width = level.width;
+  header.height = level.height;
+  header.origin_x = level.origin_x;
+  header.origin_y = level.origin_y;
+  header.tile_size = level.tile_size;
+
+  // Every record is a multiple of 4 bytes so the tables stay aligned
+  std::string baked(sizeof(header), '\0');
+  appendTable(baked, header.textures_offset, textures);
+  appendTable(baked, header.chunks_offset, chunks);
+  appendTable(baked, header.sprites_offset, sprites);
+  appendTable(baked, header.colliders_offset, colliders);
+  appendTable(baked, header.moving_tiles_offset, moving_tiles);
+  header.strings_offset = baked.size();
+  baked += strings;
+  std::memcpy(baked.data(), &header, sizeof(header));
+  return writeFileAtomic(path, baked);
+}
+
+bool BakedLevel::open(const std::string& path) {
+  close();
+  if (!file_.open(path, true)) {
+    return false;
+  }
+  BakedLevelHeader& header = header_;
+  if (file_.size() < sizeof(header)) {
+    DLOG("Baked level " << path << " is too small");
+    close();
+    return false;
+  }
+  std::memcpy(&header, file_.data(), sizeof(header));
+  if (std::memcmp(header.magic, kBakedMagic, sizeof(kBakedMagic)) != 0 ||
+      header.version != kBakedVersion ||
+      !mapTable(file_, header.textures_offset, header.num_textures,
+                textures_) ||
+      !mapTable(file_, header.chunks_offset, header.num_chunks, chunks_) ||
+      !mapTable(file_, header.sprites_offset, header.num_sprites, sprites_) ||
+      !mapTable(file_, header.colliders_offset, header.num_colliders,
+                colliders_) ||
+      !mapTable(file_, header.moving_tiles_offset, header.num_moving_tiles,
+                moving_tiles_) ||
+      header.strings_offset > file_.size() ||
+      header.strings_size > file_.size() - header.strings_offset ||
+      !(header.tile_size > 0)) {
+    DLOG("Baked level " << path << " is not a valid version "
+                        << kBakedVersion << " baked level");
+    close();
+    return false;
+  }
+  strings_ = reinterpret_cast<const char*>(file_.data() +
+                                           header.strings_offset);
+
+  bool valid{true};
+  for (const auto& texture : textures_) {
+    valid &= (size_t)texture.name.offset + texture.name.length <=
+             header.strings_size;
+  }
+  for (uint32_t i = 0; i < chunks_.size(); ++i) {
+    const BakedChunk& chunk = chunks_[i];
+    valid &= (size_t)chunk.first_sprite + chunk.num_sprites <=
+                 sprites_.size() &&
+             (size_t)chunk.first_collider + chunk.num_colliders <=
+                 colliders_.size();
+    chunk_index_.emplace(LevelChunkCoord{chunk.x, chunk.y}.getKey(), i);
+  }
+  if (!valid) {
+    DLOG("Baked level " << path << " is corrupt");
+    close();
+    return false;
+  }
+  return true;
+}
+
+void BakedLevel::close() {
+  file_.close();
+  header_ = {};
+  chunk_index_.clear();
+  textures_ = {};
+  chunks_ = {};
+  sprites_ = {};
+  colliders_ = {};
+  moving_tiles_ = {};
+  strings_ = nullptr;
+}
+
+bool BakedLevel::matches(const AssetManager& assets) const {
+  for (const auto& texture : textures_) {
+    if (assets.findHandle(std::string{getString(texture.name)}) !=
+        texture.handle) {
+      return false;
+    }
+  }
+  // Sprites index straight into the texture array so have to be in range.
+  // One branch free pass.
+  TextureHandle max_used{0};
+  for (const auto& sprite : sprites_) {
+    max_used = std::max(max_used, sprite.texture);
+  }
+  for (const auto& tile : moving_tiles_) {
+    max_used = std::max(max_used, tile.texture);
+  }
+  return max_used < assets.getTextures().size();
+}
+
+LevelChunkCoord BakedLevel::getChunkCoord(float x, float y) const {
+  const float chunk_size = header_.tile_size * kLevelChunkSize;
+  return LevelChunkCoord{
+      static_cast<int32_t>(std::floor((x - header_.origin_x) / chunk_size)),
+      static_cast<int32_t>(std::floor((y - header_.origin_y) / chunk_size))};
+}
+
+const BakedChunk* BakedLevel::findChunk(const LevelChunkCoord& coord) const {
+  auto it = chunk_index_.find(coord.getKey());
+  return it != chunk_index_.end() ? &chunks_[it->second] : nullptr;
+}
+
+int32_t BakedLevel::getNumChunksX() const {
+  return (header_.width + kLevelChunkSize - 1) / kLevelChunkSize;
+}
+
+int32_t BakedLevel::getNumChunksY() const {
+  return (header_.height + kLevelChunkSize - 1) / kLevelChunkSize;
+}
+
+// Free helper Methods
+
+// Greedy merge of the static tiles in one chunk: each row is split into
+// runs of solid tiles and a run exactly under one from the row above
+// extends that rectangle down instead of starting its own.
+void mergeColliders(const LevelData& level, const std::vector<bool>& moving,
+                    uint32_t start_x, uint32_t start_y, uint32_t end_x,
+                    uint32_t end_y, std::vector<BakedCollider>& colliders) {
+  struct OpenRect {
+    uint32_t start_x;
+    uint32_t end_x;
+    uint32_t start_y;
+  };
+  auto is_solid = [&](uint32_t x, uint32_t y) {
+    const LevelTileId tile = level.getTile(x, y);
+    return tile != kEmptyLevelTile && !moving[tile - 1];
+  };
+  auto close_rect = [&](const OpenRect& rect, uint32_t y) {
+    colliders.push_back(BakedCollider{
+        level.origin_x + rect.start_x * level.tile_size,
+        level.origin_y + rect.start_y * level.tile_size,
+        (rect.end_x - rect.start_x) * level.tile_size,
+        (y - rect.start_y) * level.tile_size});
+  };
+
+  std::vector<OpenRect> open;
+  std::vector<OpenRect> next;
+  for (uint32_t y = start_y; y < end_y; ++y) {
+    next.clear();
+    for (uint32_t x = start_x; x < end_x;) {
+      if (!is_solid(x, y)) {
+        ++x;
+        continue;
+      }
+      const uint32_t run_start = x;
+      while (x < end_x && is_solid(x, y)) {
+        ++x;
+      }
+      auto above = std::find_if(open.begin(), open.end(),
+                                [&](const OpenRect& rect) {
+                                  return rect.start_x == run_start &&
+                                         rect.end_x == x;
+                                });
+      if (above != open.end()) {
+        next.push_back(*above);
+        open.erase(above);
+      } else {
+        next.push_back(OpenRect{run_start, x, y});
+      }
+    }
+    for (const auto& rect : open) {
+      close_rect(rect, y);
+    }
+    open.swap(next);
+  }
+  for (const auto& rect : open) {
+    close_rect(rect, end_y);
+  }
+}
+
+template <typename T>
+void appendTable(std::string& baked, uint32_t& offset,
+                 const std::vector<T>& table) {
+  static_assert(sizeof(T) % 4 == 0);
+  offset = baked.size();
+  baked.append(reinterpret_cast<const char*>(table.data()),
+               table.size() * sizeof(T));
+}
+
+template <typename T>
+bool mapTable(const MappedFile& file, uint32_t offset, uint32_t count,
+              std::span<const T>& table) {
+  // Viewed in place, so a misaligned table would mean unaligned reads
+  if (offset % alignof(T) != 0 || offset > file.size() ||
+      count > (file.size() - offset) / sizeof(T)) {
+    return false;
+  }
+  table = std::span<const T>(reinterpret_cast<const T*>(file.data() + offset),
+                             count);
+  return true;
+}
+
+}  // namespace platformer2d
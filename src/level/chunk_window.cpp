@@ -0,0 +1,51 @@
+#include "level/chunk_window.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace platformer2d {
+
+// Forward declare free helpers
+int getChunkDistance(const LevelChunkCoord& a, const LevelChunkCoord& b);
+
+void ChunkWindow::reset(int32_t num_chunks_x, int32_t num_chunks_y) {
+  num_chunks_x_ = num_chunks_x;
+  num_chunks_y_ = num_chunks_y;
+  chunks_.clear();
+}
+
+void ChunkWindow::update(const LevelChunkCoord& focus,
+                         std::vector<LevelChunkCoord>& loaded,
+                         std::vector<LevelChunkCoord>& unloaded) {
+  for (auto it = chunks_.begin(); it != chunks_.end();) {
+    const LevelChunkCoord coord = LevelChunkCoord::fromKey(*it);
+    if (getChunkDistance(coord, focus) > kChunkUnloadRadius) {
+      unloaded.push_back(coord);
+      it = chunks_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (int y = focus.y - kChunkLoadRadius; y <= focus.y + kChunkLoadRadius;
+       ++y) {
+    for (int x = focus.x - kChunkLoadRadius; x <= focus.x + kChunkLoadRadius;
+         ++x) {
+      const LevelChunkCoord coord{x, y};
+      if (isInLevel(coord) && chunks_.insert(coord.getKey()).second) {
+        loaded.push_back(coord);
+      }
+    }
+  }
+}
+
+bool ChunkWindow::isInLevel(const LevelChunkCoord& coord) const {
+  return coord.x >= 0 && coord.y >= 0 && coord.x < num_chunks_x_ &&
+         coord.y < num_chunks_y_;
+}
+
+// Free helper Methods
+int getChunkDistance(const LevelChunkCoord& a, const LevelChunkCoord& b) {
+  return std::max(std::abs(a.x - b.x), std::abs(a.y - b.y));
+}
+
+}  // namespace platformer2d
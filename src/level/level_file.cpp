@@ -0,0 +1,282 @@
+#include "level/level_file.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+#include "atomic_file.h"
+#include "debug.h"
+#include "level/level_json_reader.h"
+
+namespace platformer2d {
+
+constexpr char kLevelMagic[4]{'P', '2', 'D', 'L'};
+constexpr uint32_t kLevelVersion{1};
+
+// Forward declare free helpers
+size_t alignLevelOffset(size_t offset);
+bool isInFile(size_t offset, size_t count, size_t item_size,
+              size_t alignment, size_t size);
+
+LevelTileId LevelData::getTileId(const std::string& texture_name) {
+  auto it = std::find(palette.begin(), palette.end(), texture_name);
+  if (it != palette.end()) {
+    return static_cast<LevelTileId>(it - palette.begin() + 1);
+  }
+  CHECK(palette.size() < std::numeric_limits<LevelTileId>::max(),
+        "Too many textures in one level");
+  palette.push_back(texture_name);
+  return static_cast<LevelTileId>(palette.size());
+}
+
+bool LevelData::fromJson(std::istream& input, LevelData& level) {
+  level = LevelData{};
+  // The width is only known once every row is read, so gather rows first
+  std::vector<std::vector<LevelTileId>> rows;
+  // Tiles are stored on a grid so only the first placed tile's position is
+  // kept, as the grid origin
+  bool has_origin{false};
+  auto on_cell = [&](const LevelJsonCell& cell) {
+    if (cell.grid_y >= rows.size()) {
+      rows.resize(cell.grid_y + 1);
+    }
+    auto& row = rows[cell.grid_y];
+    row.resize(cell.grid_x + 1, kEmptyLevelTile);
+    if (cell.texture_name.empty()) return;
+    if (!has_origin) {
+      level.origin_x = cell.x - cell.grid_x * level.tile_size;
+      level.origin_y = cell.y - cell.grid_y * level.tile_size;
+      has_origin = true;
+    } else if (std::abs(level.origin_x + cell.grid_x * level.tile_size -
+                        cell.x) +
+                   std::abs(level.origin_y + cell.grid_y * level.tile_size -
+                            cell.y) >
+               0.5f) {
+      DLOG("Tile " << cell.grid_x << ", " << cell.grid_y
+                   << " is off the grid, snapping it");
+    }
+    row[cell.grid_x] = level.getTileId(std::string{cell.texture_name});
+  };
+  auto on_entity = [&level](const LevelEntity& entity) {
+    level.entities.push_back(entity);
+  };
+  if (!readLevelJson(input, on_cell, on_entity)) {
+    return false;
+  }
+
+  level.height = rows.size();
+  for (const auto& row : rows) {
+    level.width = std::max<uint32_t>(level.width, row.size());
+  }
+  level.tiles.assign(level.width * level.height, kEmptyLevelTile);
+  for (uint32_t y = 0; y < level.height; ++y) {
+    std::copy(rows[y].begin(), rows[y].end(),
+              level.tiles.begin() + y * level.width);
+  }
+  return true;
+}
+
+nlohmann::json LevelData::toJson() const {
+  nlohmann::json json;
+  auto& rows = json["tile_map"]["tiles"];
+  rows = nlohmann::json::array();
+  for (uint32_t y = 0; y < height; ++y) {
+    rows.push_back(rowToJson(y));
+  }
+  if (!entities.empty()) {
+    json["entities"] = entitiesToJson();
+  }
+  return json;
+}
+
+nlohmann::json LevelData::rowToJson(uint32_t y) const {
+  nlohmann::json row = nlohmann::json::array();
+  for (uint32_t x = 0; x < width; ++x) {
+    const LevelTileId tile = getTile(x, y);
+    nlohmann::json tile_json;
+    tile_json["x"] = origin_x + x * tile_size;
+    tile_json["y"] = origin_y + y * tile_size;
+    tile_json["texture_name"] =
+        tile == kEmptyLevelTile ? "" : palette[tile - 1];
+    row.push_back(tile_json);
+  }
+  return row;
+}
+
+nlohmann::json LevelData::entitiesToJson() const {
+  nlohmann::json json = nlohmann::json::array();
+  for (const auto& entity : entities) {
+    json.push_back({{"name", entity.name}, {"x", entity.x}, {"y", entity.y}});
+  }
+  return json;
+}
+
+std::string LevelData::toBinary() const {
+  std::string strings;
+  auto add_string = [&strings](const std::string& string) {
+    LevelFileString stored{static_cast<uint32_t>(strings.size()),
+                           static_cast<uint32_t>(string.size())};
+    strings += string;
+    return stored;
+  };
+  std::vector<LevelFileString> stored_palette;
+  for (const auto& name : palette) {
+    stored_palette.push_back(add_string(name));
+  }
+  std::vector<LevelFileEntity> stored_entities;
+  for (const auto& entity : entities) {
+    stored_entities.push_back(
+        LevelFileEntity{add_string(entity.name), entity.x, entity.y});
+  }
+
+  LevelFileHeader header{};
+  std::memcpy(header.magic, kLevelMagic, sizeof(kLevelMagic));
+  header.version = kLevelVersion;
+  header.width = width;
+  header.height = height;
+  header.origin_x = origin_x;
+  header.origin_y = origin_y;
+  header.tile_size = tile_size;
+  header.palette_size = palette.size();
+  header.palette_offset = sizeof(LevelFileHeader);
+  header.num_entities = entities.size();
+  header.entities_offset =
+      header.palette_offset + palette.size() * sizeof(LevelFileString);
+  header.tiles_offset =
+      header.entities_offset + entities.size() * sizeof(LevelFileEntity);
+  header.strings_offset = alignLevelOffset(
+      header.tiles_offset + tiles.size() * sizeof(LevelTileId));
+  header.strings_size = strings.size();
+
+  std::string binary;
+  binary.reserve(header.strings_offset + strings.size());
+  auto append = [&binary](const void* data, size_t size) {
+    binary.append(static_cast<const char*>(data), size);
+  };
+  append(&header, sizeof(header));
+  append(stored_palette.data(),
+         stored_palette.size() * sizeof(LevelFileString));
+  append(stored_entities.data(),
+         stored_entities.size() * sizeof(LevelFileEntity));
+  append(tiles.data(), tiles.size() * sizeof(LevelTileId));
+  binary.resize(header.strings_offset, '\0');
+  binary += strings;
+  return binary;
+}
+
+bool LevelData::saveBinary(const std::string& path) const {
+  // Streamed levels stay mapped while the game runs and truncating a mapped
+  // file crashes the reader, so the new file is swapped in whole
+  return writeFileAtomic(path, toBinary());
+}
+
+bool LevelFile::open(const std::string& path) {
+  if (!file_.open(path)) {
+    return false;
+  }
+  const uint8_t* data = file_.data();
+  const size_t size = file_.size();
+  if (size < sizeof(LevelFileHeader)) {
+    DLOG("Level file " << path << " is too small");
+    file_.close();
+    return false;
+  }
+  std::memcpy(&header_, data, sizeof(header_));
+  const size_t num_tiles = (size_t)header_.width * header_.height;
+  if (std::memcmp(header_.magic, kLevelMagic, sizeof(kLevelMagic)) != 0 ||
+      header_.version != kLevelVersion ||
+      !isInFile(header_.palette_offset, header_.palette_size,
+                sizeof(LevelFileString), alignof(LevelFileString), size) ||
+      !isInFile(header_.entities_offset, header_.num_entities,
+                sizeof(LevelFileEntity), alignof(LevelFileEntity), size) ||
+      !isInFile(header_.tiles_offset, num_tiles, sizeof(LevelTileId),
+                alignof(LevelTileId), size) ||
+      !isInFile(header_.strings_offset, header_.strings_size, 1, 1, size)) {
+    DLOG("Level file " << path << " is not a valid version " << kLevelVersion
+                       << " level");
+    file_.close();
+    return false;
+  }
+  palette_ = std::span<const LevelFileString>(
+      reinterpret_cast<const LevelFileString*>(data + header_.palette_offset),
+      header_.palette_size);
+  entities_ = std::span<const LevelFileEntity>(
+      reinterpret_cast<const LevelFileEntity*>(data + header_.entities_offset),
+      header_.num_entities);
+  tiles_ = std::span<const LevelTileId>(
+      reinterpret_cast<const LevelTileId*>(data + header_.tiles_offset),
+      num_tiles);
+  strings_ = reinterpret_cast<const char*>(data + header_.strings_offset);
+
+  bool valid{true};
+  for (const auto& string : palette_) {
+    valid &= (size_t)string.offset + string.length <= header_.strings_size;
+  }
+  for (const auto& entity : entities_) {
+    valid &=
+        (size_t)entity.name.offset + entity.name.length <= header_.strings_size;
+  }
+  // Branch free so it vectorises, this is the only pass over the grid
+  LevelTileId max_tile{kEmptyLevelTile};
+  for (LevelTileId tile : tiles_) {
+    max_tile = std::max(max_tile, tile);
+  }
+  if (!valid || max_tile > header_.palette_size) {
+    DLOG("Level file " << path << " is corrupt");
+    file_.close();
+    return false;
+  }
+  return true;
+}
+
+void LevelFile::close() {
+  file_.close();
+  header_ = LevelFileHeader{};
+  palette_ = {};
+  entities_ = {};
+  tiles_ = {};
+  strings_ = nullptr;
+}
+
+LevelData LevelFile::toData() const {
+  LevelData level;
+  level.width = header_.width;
+  level.height = header_.height;
+  level.origin_x = header_.origin_x;
+  level.origin_y = header_.origin_y;
+  level.tile_size = header_.tile_size;
+  for (const auto& name : palette_) {
+    level.palette.emplace_back(getString(name));
+  }
+  level.tiles.assign(tiles_.begin(), tiles_.end());
+  for (const auto& entity : entities_) {
+    level.entities.push_back(
+        LevelEntity{std::string{getString(entity.name)}, entity.x, entity.y});
+  }
+  return level;
+}
+
+bool isBinaryLevelCurrent(const std::string& json_path,
+                          const std::string& binary_path) {
+  std::error_code error;
+  const auto binary_time =
+      std::filesystem::last_write_time(binary_path, error);
+  if (error) return false;
+  const auto json_time = std::filesystem::last_write_time(json_path, error);
+  return error || binary_time >= json_time;
+}
+
+// Free helper Methods
+size_t alignLevelOffset(size_t offset) { return (offset + 3) & ~size_t{3}; }
+
+// The tables are viewed in place, so a misaligned one would mean unaligned
+// typed reads
+bool isInFile(size_t offset, size_t count, size_t item_size,
+              size_t alignment, size_t size) {
+  return offset % alignment == 0 && offset <= size &&
+         count <= (size - offset) / item_size;
+}
+
+}  // namespace platformer2d
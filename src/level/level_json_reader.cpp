@@ -0,0 +1,164 @@
+#include "level/level_json_reader.h"
+
+#include <string>
+#include <vector>
+
+#include "debug.h"
+#include "nlohmann/json.hpp"
+
+namespace platformer2d {
+
+// Tracks where in the document the parser is. Only the parts of a level
+// that are read get their own context, everything else is skipped.
+class LevelSaxHandler : public nlohmann::json_sax<nlohmann::json> {
+ public:
+  LevelSaxHandler(const LevelCellCallback& on_cell,
+                  const LevelEntityCallback& on_entity)
+      : on_cell_(on_cell), on_entity_(on_entity) {}
+
+  bool hasTiles() const { return has_tiles_; }
+
+  bool null() override { return true; }
+  bool boolean(bool /*value*/) override { return true; }
+  bool number_integer(number_integer_t value) override {
+    return number(value);
+  }
+  bool number_unsigned(number_unsigned_t value) override {
+    return number(value);
+  }
+  bool number_float(number_float_t value,
+                    const string_t& /*text*/) override {
+    return number(value);
+  }
+  bool binary(binary_t& /*value*/) override { return true; }
+
+  bool string(string_t& value) override {
+    if (top() == Context::kCell && key_ == "texture_name") {
+      cell_texture_ = std::move(value);
+    } else if (top() == Context::kEntity && key_ == "name") {
+      entity_.name = std::move(value);
+    }
+    return true;
+  }
+
+  bool key(string_t& value) override {
+    key_ = std::move(value);
+    return true;
+  }
+
+  bool start_object(std::size_t /*size*/) override {
+    Context context{Context::kSkip};
+    if (stack_.empty()) {
+      context = Context::kRoot;
+    } else if (top() == Context::kRoot && key_ == "tile_map") {
+      context = Context::kTileMap;
+    } else if (top() == Context::kRow) {
+      context = Context::kCell;
+      cell_texture_.clear();
+      cell_x_ = cell_y_ = 0;
+    } else if (top() == Context::kEntities) {
+      context = Context::kEntity;
+      entity_ = LevelEntity{};
+    }
+    stack_.push_back(context);
+    return true;
+  }
+
+  bool end_object() override {
+    const Context context = pop();
+    if (context == Context::kCell) {
+      on_cell_(LevelJsonCell{column_, row_, cell_texture_, cell_x_, cell_y_});
+      ++column_;
+    } else if (context == Context::kEntity && on_entity_) {
+      on_entity_(entity_);
+    }
+    return true;
+  }
+
+  bool start_array(std::size_t /*size*/) override {
+    Context context{Context::kSkip};
+    if (top() == Context::kTileMap && key_ == "tiles") {
+      context = Context::kRows;
+      has_tiles_ = true;
+    } else if (top() == Context::kRows) {
+      context = Context::kRow;
+      column_ = 0;
+    } else if (top() == Context::kRoot && key_ == "entities") {
+      context = Context::kEntities;
+    }
+    stack_.push_back(context);
+    return true;
+  }
+
+  bool end_array() override {
+    if (pop() == Context::kRow) {
+      ++row_;
+    }
+    return true;
+  }
+
+  bool parse_error(std::size_t position, const std::string& /*last_token*/,
+                   const nlohmann::detail::exception& error) override {
+    LOG_WARNING("Level json error at byte " << position << ": "
+                                            << error.what());
+    return false;
+  }
+
+ private:
+  enum class Context {
+    kRoot,
+    kTileMap,
+    kRows,
+    kRow,
+    kCell,
+    kEntities,
+    kEntity,
+    kSkip,
+  };
+
+  const LevelCellCallback& on_cell_;
+  const LevelEntityCallback& on_entity_;
+  std::vector<Context> stack_;
+  std::string key_;
+  bool has_tiles_{false};
+
+  uint32_t row_{0};
+  uint32_t column_{0};
+  std::string cell_texture_;
+  float cell_x_{0};
+  float cell_y_{0};
+  LevelEntity entity_;
+
+  Context top() const {
+    return stack_.empty() ? Context::kSkip : stack_.back();
+  }
+
+  Context pop() {
+    const Context context = top();
+    if (!stack_.empty()) {
+      stack_.pop_back();
+    }
+    return context;
+  }
+
+  bool number(double value) {
+    float* field{nullptr};
+    if (top() == Context::kCell) {
+      field = key_ == "x" ? &cell_x_ : key_ == "y" ? &cell_y_ : nullptr;
+    } else if (top() == Context::kEntity) {
+      field = key_ == "x" ? &entity_.x : key_ == "y" ? &entity_.y : nullptr;
+    }
+    if (field != nullptr) {
+      *field = static_cast<float>(value);
+    }
+    return true;
+  }
+};
+
+bool readLevelJson(std::istream& input, const LevelCellCallback& on_cell,
+                   const LevelEntityCallback& on_entity) {
+  LevelSaxHandler handler{on_cell, on_entity};
+  return nlohmann::json::sax_parse(input, &handler) && handler.hasTiles();
+}
+
+}  // namespace platformer2d
@@ -0,0 +1,162 @@
+#include "level/level_streamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "profiling/profiler.h"
+
+namespace platformer2d {
+
+LevelStreamer::~LevelStreamer() { close(); }
+
+bool LevelStreamer::open(const std::string& path) {
+  close();
+  if (!level_.open(path)) {
+    return false;
+  }
+  wanted_.reset((level_.getWidth() + kLevelChunkSize - 1) / kLevelChunkSize,
+                (level_.getHeight() + kLevelChunkSize - 1) / kLevelChunkSize);
+  stopping_ = false;
+  worker_ = std::thread(&LevelStreamer::streamWorker, this);
+  return true;
+}
+
+void LevelStreamer::close() {
+  if (worker_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stopping_ = true;
+    }
+    requested_.notify_all();
+    worker_.join();
+  }
+  requests_.clear();
+  loaded_.clear();
+  wanted_.reset(0, 0);
+  level_.close();
+}
+
+std::vector<LevelChunk> LevelStreamer::loadAround(float focus_x,
+                                                  float focus_y) {
+  std::vector<LevelChunkCoord> wanted;
+  std::vector<LevelChunkCoord> unloaded;
+  wanted_.update(getChunkCoord(focus_x, focus_y), wanted, unloaded);
+  std::vector<LevelChunk> chunks;
+  for (const auto& coord : wanted) {
+    chunks.push_back(readChunk(coord));
+  }
+  return chunks;
+}
+
+void LevelStreamer::update(float focus_x, float focus_y,
+                           std::vector<LevelChunkCoord>& unloaded) {
+  const size_t num_unloaded = unloaded.size();
+  std::vector<LevelChunkCoord> wanted;
+  wanted_.update(getChunkCoord(focus_x, focus_y), wanted, unloaded);
+  if (wanted.empty() && unloaded.size() == num_unloaded) return;
+
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    // Don't bother reading chunks the focus already left
+    std::erase_if(requests_, [this](const LevelChunkCoord& coord) {
+      return !wanted_.contains(coord);
+    });
+    requests_.insert(requests_.end(), wanted.begin(), wanted.end());
+  }
+  requested_.notify_one();
+}
+
+bool LevelStreamer::popLoadedChunk(LevelChunk& chunk) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  while (!loaded_.empty()) {
+    chunk = std::move(loaded_.back());
+    loaded_.pop_back();
+    // Finished after the focus moved away again
+    if (wanted_.contains(chunk.coord)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<std::string_view> LevelStreamer::getTextureNames() const {
+  std::vector<std::string_view> names;
+  for (const auto& name : level_.getPalette()) {
+    names.push_back(level_.getString(name));
+  }
+  return names;
+}
+
+std::vector<LevelChunkTile> LevelStreamer::findTiles(
+    std::string_view texture_name) const {
+  PROFILE_SCOPE("LevelStreamer::findTiles");
+  std::vector<LevelChunkTile> tiles;
+  const auto palette = level_.getPalette();
+  const auto it = std::find_if(
+      palette.begin(), palette.end(), [&](const LevelFileString& name) {
+        return level_.getString(name) == texture_name;
+      });
+  // Most levels don't use it at all so the grid needn't be read
+  if (it == palette.end()) return tiles;
+  const LevelTileId id = static_cast<LevelTileId>(it - palette.begin() + 1);
+  const LevelFileHeader& header = level_.getHeader();
+  for (uint32_t y = 0; y < header.height; ++y) {
+    for (uint32_t x = 0; x < header.width; ++x) {
+      if (level_.getTile(x, y) != id) continue;
+      tiles.push_back(LevelChunkTile{x, y, level_.getTextureName(id),
+                                     header.origin_x + x * header.tile_size,
+                                     header.origin_y + y * header.tile_size});
+    }
+  }
+  return tiles;
+}
+
+LevelChunkCoord LevelStreamer::getChunkCoord(float x, float y) const {
+  const LevelFileHeader& header = level_.getHeader();
+  const float chunk_size = header.tile_size * kLevelChunkSize;
+  return LevelChunkCoord{
+      static_cast<int32_t>(std::floor((x - header.origin_x) / chunk_size)),
+      static_cast<int32_t>(std::floor((y - header.origin_y) / chunk_size))};
+}
+
+LevelChunk LevelStreamer::readChunk(const LevelChunkCoord& coord) const {
+  PROFILE_SCOPE("LevelStreamer::readChunk");
+  const LevelFileHeader& header = level_.getHeader();
+  const uint32_t start_x = coord.x * kLevelChunkSize;
+  const uint32_t start_y = coord.y * kLevelChunkSize;
+  const uint32_t end_x = std::min(start_x + kLevelChunkSize, header.width);
+  const uint32_t end_y = std::min(start_y + kLevelChunkSize, header.height);
+  LevelChunk chunk{coord, {}};
+  for (uint32_t y = start_y; y < end_y; ++y) {
+    for (uint32_t x = start_x; x < end_x; ++x) {
+      const LevelTileId tile = level_.getTile(x, y);
+      if (tile == kEmptyLevelTile) continue;
+      chunk.tiles.push_back(
+          LevelChunkTile{x, y, level_.getTextureName(tile),
+                         header.origin_x + x * header.tile_size,
+                         header.origin_y + y * header.tile_size});
+    }
+  }
+  return chunk;
+}
+
+void LevelStreamer::streamWorker() {
+  PROFILE_THREAD_NAME("level stream");
+  while (true) {
+    LevelChunkCoord coord;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      requested_.wait(lock,
+                      [this] { return stopping_ || !requests_.empty(); });
+      if (stopping_) return;
+      coord = requests_.front();
+      requests_.pop_front();
+    }
+    // Touching the grid is what faults the chunk's pages in from disk
+    LevelChunk chunk = readChunk(coord);
+    std::lock_guard<std::mutex> lock{mutex_};
+    loaded_.push_back(std::move(chunk));
+  }
+}
+
+}  // namespace platformer2d
@@ -0,0 +1,129 @@
+#include "level_editor/level_saver.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "atomic_file.h"
+#include "debug.h"
+#include "profiling/profiler.h"
+
+namespace platformer2d {
+
+LevelSaver::LevelSaver(std::string json_path, std::string binary_path)
+    : json_path_(std::move(json_path)), binary_path_(std::move(binary_path)) {
+  // Started last so it never sees a half constructed saver
+  worker_ = std::thread(&LevelSaver::saveWorker, this);
+}
+
+LevelSaver::~LevelSaver() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  requested_.notify_one();
+  worker_.join();
+}
+
+void LevelSaver::save(TileMap& tile_map) {
+  Snapshot snapshot{tile_map.toLevelData(), {}};
+  snapshot.dirty_rows.assign(snapshot.level.height, 0);
+  for (size_t chunk_y = 0; chunk_y < tile_map.getNumChunksY(); ++chunk_y) {
+    bool dirty{false};
+    for (size_t chunk_x = 0; chunk_x < tile_map.getNumChunksX(); ++chunk_x) {
+      dirty |= tile_map.isChunkDirty(chunk_x, chunk_y);
+    }
+    if (!dirty) continue;
+    const size_t end_y = std::min<size_t>((chunk_y + 1) * kLevelChunkSize,
+                                          snapshot.level.height);
+    for (size_t y = chunk_y * kLevelChunkSize; y < end_y; ++y) {
+      snapshot.dirty_rows[y] = 1;
+    }
+  }
+  tile_map.clearDirty();
+
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    // A queued snapshot's dirty rows still need writing. Painting or
+    // erasing the bottom row changes the height in between, rows past the
+    // shorter of the two can't be matched up so are written again.
+    if (pending_) {
+      const size_t common = std::min(pending_->dirty_rows.size(),
+                                     snapshot.dirty_rows.size());
+      for (size_t y = 0; y < common; ++y) {
+        snapshot.dirty_rows[y] |= pending_->dirty_rows[y];
+      }
+      std::fill(snapshot.dirty_rows.begin() + common,
+                snapshot.dirty_rows.end(), 1);
+    }
+    pending_ = std::move(snapshot);
+  }
+  requested_.notify_one();
+}
+
+void LevelSaver::flush() {
+  PROFILE_SCOPE("LevelSaver::flush");
+  std::unique_lock<std::mutex> lock{mutex_};
+  idle_.wait(lock, [this] { return !pending_ && !writing_; });
+}
+
+void LevelSaver::saveWorker() {
+  PROFILE_THREAD_NAME("level save");
+  while (true) {
+    Snapshot snapshot;
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      requested_.wait(lock, [this] { return stopping_ || pending_; });
+      // Stopping still writes what was queued
+      if (!pending_) return;
+      snapshot = std::move(*pending_);
+      pending_.reset();
+      writing_ = true;
+    }
+    const bool saved = writeSnapshot(snapshot);
+    failed_ = !saved;
+    if (saved) {
+      DLOG("Saved level to " << json_path_ << " and " << binary_path_);
+    }
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      writing_ = false;
+    }
+    idle_.notify_all();
+  }
+}
+
+bool LevelSaver::writeSnapshot(const Snapshot& snapshot) {
+  PROFILE_SCOPE("LevelSaver::writeSnapshot");
+  const LevelData& level = snapshot.level;
+  // Painting past the last column widens every row
+  if (row_json_.size() != level.height || row_json_width_ != level.width) {
+    row_json_.assign(level.height, std::string{});
+    row_json_width_ = level.width;
+  }
+  for (uint32_t y = 0; y < level.height; ++y) {
+    if (snapshot.dirty_rows[y] || row_json_[y].empty()) {
+      row_json_[y] = level.rowToJson(y).dump();
+    }
+  }
+  // Same document as LevelData::toJson().dump(), keys in nlohmann's order
+  std::string json{"{"};
+  if (!level.entities.empty()) {
+    json += "\"entities\":" + level.entitiesToJson().dump() + ",";
+  }
+  json += "\"tile_map\":{\"tiles\":[";
+  for (uint32_t y = 0; y < level.height; ++y) {
+    if (y > 0) json += ',';
+    json += row_json_[y];
+  }
+  json += "]}}";
+
+  if (!writeFileAtomic(json_path_, json) ||
+      !writeFileAtomic(binary_path_, level.toBinary())) {
+    // Nothing on disk can be trusted to match the cached rows any more
+    row_json_.clear();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace platformer2d
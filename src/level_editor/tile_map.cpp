@@ -1,81 +1,476 @@
 #include "level_editor/tile_map.h"
 
-#include <functional>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <memory>
 #include <vector>
 
 #include "debug.h"
+#include "level/level_json_reader.h"
 #include "managers/asset_manager.h"
 #include "raylib.h"
 
 namespace platformer2d {
 
+static_assert(64 % kLevelChunkSize == 0,
+              "A chunk row has to fit in one occupied word");
+
 TileMap::TileMap(size_t max_tiles_x, size_t max_tiles_y,
-                 AssetManager& asset_manager)
+                 AssetManager& asset_manager, float origin_x, float origin_y)
     : max_tiles_x_(max_tiles_x),
       max_tiles_y_(max_tiles_y),
-      tiles_{max_tiles_y_, std::vector<Tile>(max_tiles_x_)},
+      origin_x_(origin_x),
+      origin_y_(origin_y),
+      num_chunks_x_((max_tiles_x_ + kLevelChunkSize - 1) / kLevelChunkSize),
+      num_chunks_y_((max_tiles_y_ + kLevelChunkSize - 1) / kLevelChunkSize),
+      chunks_(num_chunks_x_ * num_chunks_y_),
+      dirty_chunks_(num_chunks_x_ * num_chunks_y_, 0),
       asset_manager_(asset_manager) {}
 
-const TilesVec& TileMap::getTiles() const { return tiles_; }
+bool TileMap::fromJson(std::istream& input) {
+  return readLevelJson(input, [this](const LevelJsonCell& cell) {
+    addTile(cell.grid_x, cell.grid_y,
+            cell.texture_name.empty()
+                ? kInvalidTexture
+                : asset_manager_.getHandle(std::string{cell.texture_name}));
+  });
+}
 
-nlohmann::json TileMap::toJson() const {
-  nlohmann::json json;
-  for (const auto& row : getTiles()) {
-    std::vector<nlohmann::json> tile_row;
-    for (const auto& tile : row) {
-      tile_row.push_back(tile.toJson());
+LevelData TileMap::toLevelData() const {
+  LevelData level;
+  level.origin_x = origin_x_;
+  level.origin_y = origin_y_;
+  // The level only reaches as far as the furthest painted cell
+  for (size_t chunk_y = 0; chunk_y < num_chunks_y_; ++chunk_y) {
+    for (size_t chunk_x = 0; chunk_x < num_chunks_x_; ++chunk_x) {
+      const Chunk* chunk = chunks_[chunk_y * num_chunks_x_ + chunk_x].get();
+      if (!chunk) continue;
+      for (size_t row = 0; row < kLevelChunkSize; ++row) {
+        const uint64_t bits = getChunkRow(*chunk, row);
+        if (bits == 0) continue;
+        level.width = std::max<uint32_t>(
+            level.width, chunk_x * kLevelChunkSize + std::bit_width(bits));
+        level.height = std::max<uint32_t>(
+            level.height, chunk_y * kLevelChunkSize + row + 1);
+      }
+    }
+  }
+  level.tiles.assign((size_t)level.width * level.height, kEmptyLevelTile);
+  for (size_t chunk_y = 0; chunk_y < num_chunks_y_; ++chunk_y) {
+    for (size_t chunk_x = 0; chunk_x < num_chunks_x_; ++chunk_x) {
+      const Chunk* chunk = chunks_[chunk_y * num_chunks_x_ + chunk_x].get();
+      if (!chunk) continue;
+      for (size_t row = 0; row < kLevelChunkSize; ++row) {
+        const size_t y = chunk_y * kLevelChunkSize + row;
+        for (uint64_t bits = getChunkRow(*chunk, row); bits != 0;
+             bits &= bits - 1) {
+          const size_t column = std::countr_zero(bits);
+          level.tiles[y * level.width + chunk_x * kLevelChunkSize + column] =
+              chunk->tiles[row * kLevelChunkSize + column];
+        }
+      }
     }
-    json["tiles"].push_back(tile_row);
   }
-  return json;
+  // Textures no longer on the map drop out of the saved palette. Resolved
+  // in row order so the palette matches a level converted from the json.
+  std::vector<LevelTileId> saved_ids(palette_.size() + 1, kEmptyLevelTile);
+  for (LevelTileId& tile : level.tiles) {
+    if (tile == kEmptyLevelTile) continue;
+    if (saved_ids[tile] == kEmptyLevelTile) {
+      saved_ids[tile] =
+          level.getTileId(asset_manager_.getName(getTexture(tile)));
+    }
+    tile = saved_ids[tile];
+  }
+  return level;
 }
 
-void TileMap::fromJson(const nlohmann::json& json) {
-  DLOG("Loading tile map from json:\n" << json.dump(2));
-  for (size_t y = 0; y < json["tiles"].size(); ++y) {
-    for (size_t x = 0; x < json["tiles"][y].size(); ++x) {
-      const auto& tile = json["tiles"][y][x];
-      addTile(x, y, tile["x"], tile["y"], tile["texture_name"]);
+void TileMap::fromLevelData(const LevelData& level) {
+  const size_t width = std::min<size_t>(level.width, max_tiles_x_);
+  const size_t height = std::min<size_t>(level.height, max_tiles_y_);
+  // Resolve each palette entry once rather than every tile
+  std::vector<TextureHandle> textures;
+  for (const auto& name : level.palette) {
+    textures.push_back(asset_manager_.getHandle(name));
+  }
+  for (size_t y = 0; y < height; ++y) {
+    for (size_t x = 0; x < width; ++x) {
+      const LevelTileId tile = level.getTile(x, y);
+      addTile(x, y,
+              tile == kEmptyLevelTile ? kInvalidTexture : textures[tile - 1]);
     }
   }
 }
 
-bool TileMap::addTile(size_t tile_x, size_t tile_y, float pos_x, float pos_y,
-                      std::string texture_name) {
+bool TileMap::addTile(size_t tile_x, size_t tile_y, TextureHandle texture) {
   if (!isInBounds(tile_x, tile_y)) {
     return false;
   }
-  tiles_[tile_y][tile_x].texture_name = texture_name;
-  tiles_[tile_y][tile_x].x = pos_x;
-  tiles_[tile_y][tile_x].y = pos_y;
+  if (getTexture(getCell(tile_x, tile_y)) == texture) {
+    return true;
+  }
+  fillRow(tile_x, tile_x + 1, tile_y,
+          texture == kInvalidTexture ? kEmptyLevelTile : getTileId(texture));
   return true;
 }
 
-std::optional<std::reference_wrapper<const Tile>> TileMap::getTile(
-    size_t tile_x, size_t tile_y) const {
+bool TileMap::fillRect(const TileRange& range, TextureHandle texture) {
+  if (range.start_x > range.end_x || range.start_y > range.end_y ||
+      range.end_x > max_tiles_x_ || range.end_y > max_tiles_y_) {
+    return false;
+  }
+  const LevelTileId tile =
+      texture == kInvalidTexture ? kEmptyLevelTile : getTileId(texture);
+  for (size_t y = range.start_y; y < range.end_y; ++y) {
+    fillRow(range.start_x, range.end_x, y, tile);
+  }
+  return true;
+}
+
+bool TileMap::floodFill(size_t tile_x, size_t tile_y, TextureHandle texture) {
+  if (!isInBounds(tile_x, tile_y)) {
+    return false;
+  }
+  // One fill at a time, the one asked for first finishes first
+  continueFloodFill(std::numeric_limits<size_t>::max());
+  fill_target_ = getCell(tile_x, tile_y);
+  fill_tile_ =
+      texture == kInvalidTexture ? kEmptyLevelTile : getTileId(texture);
+  if (fill_target_ == fill_tile_) {
+    return true;
+  }
+  // The seed isn't a filled run, so the row above it has to be searched
+  // as well as the one below
+  fill_spans_.push_back(FillSpan{tile_x, tile_x + 1, tile_y, 1});
+  if (tile_y > 0) {
+    fill_spans_.push_back(FillSpan{tile_x, tile_x + 1, tile_y - 1, -1});
+  }
+  return true;
+}
+
+// Scanline fill: each run of the target tile is filled whole, then the
+// cells next to it in the row ahead are searched for more runs. Looking back
+// only needs the part of a run sticking out past the span it was found in,
+// the rest is the run that span came from and already filled. Runs are found
+// from the chunks' occupied bits or a 16 cell compare rather than cell by
+// cell.
+bool TileMap::continueFloodFill(size_t max_cells) {
+  size_t cells{0};
+  while (!fill_spans_.empty() && cells < max_cells) {
+    const FillSpan span = fill_spans_.back();
+    fill_spans_.pop_back();
+    cells += span.end_x - span.start_x;
+    size_t x = findCell(span.start_x, span.end_x, span.y, fill_target_);
+    while (x < span.end_x) {
+      const size_t start_x = getRunStart(x, span.y, fill_target_);
+      const size_t end_x = getRunEnd(x, span.y, fill_target_);
+      fillRow(start_x, end_x, span.y, fill_tile_);
+      cells += end_x - start_x;
+      pushFillSpan(start_x, end_x, span.y, span.dy);
+      if (start_x < span.start_x) {
+        pushFillSpan(start_x, span.start_x, span.y, -span.dy);
+      }
+      if (end_x > span.end_x) {
+        pushFillSpan(span.end_x, end_x, span.y, -span.dy);
+      }
+      x = findCell(end_x, span.end_x, span.y, fill_target_);
+    }
+  }
+  return fill_spans_.empty();
+}
+
+TileRegion TileMap::copyRegion(const TileRange& range) const {
+  TileRegion region;
+  const size_t end_x = std::min(range.end_x, max_tiles_x_);
+  const size_t end_y = std::min(range.end_y, max_tiles_y_);
+  if (range.start_x >= end_x || range.start_y >= end_y) {
+    return region;
+  }
+  region.width = end_x - range.start_x;
+  region.height = end_y - range.start_y;
+  region.textures.reserve(region.width * region.height);
+  for (size_t y = range.start_y; y < end_y; ++y) {
+    for (size_t x = range.start_x; x < end_x; ++x) {
+      region.textures.push_back(getTexture(getCell(x, y)));
+    }
+  }
+  return region;
+}
+
+bool TileMap::pasteRegion(const TileRegion& region, size_t tile_x,
+                          size_t tile_y) {
+  if (!isInBounds(tile_x, tile_y)) {
+    return false;
+  }
+  const size_t width = std::min(region.width, max_tiles_x_ - tile_x);
+  const size_t height = std::min(region.height, max_tiles_y_ - tile_y);
+  std::vector<LevelTileId> row(width);
+  for (size_t y = 0; y < height; ++y) {
+    for (size_t x = 0; x < width; ++x) {
+      const TextureHandle texture = region.textures[y * region.width + x];
+      row[x] =
+          texture == kInvalidTexture ? kEmptyLevelTile : getTileId(texture);
+    }
+    writeRow(tile_x, tile_y + y, row);
+  }
+  return true;
+}
+
+std::optional<Tile> TileMap::getTile(size_t tile_x, size_t tile_y) const {
   if (!isInBounds(tile_x, tile_y)) {
     return std::nullopt;
   }
-  return std::ref(tiles_[tile_y][tile_x]);
+  return Tile{static_cast<int>(origin_x_ + tile_x * kTileSize),
+              static_cast<int>(origin_y_ + tile_y * kTileSize),
+              getTexture(getCell(tile_x, tile_y))};
+}
+
+void TileMap::draw(RenderCommandList& commands) const {
+  draw(commands, Rectangle{origin_x_, origin_y_, max_tiles_x_ * kTileSize,
+                           max_tiles_y_ * kTileSize});
 }
 
-void TileMap::draw() const {
-  // Draw in the placed tiles
-  for (const auto& row : getTiles()) {
-    for (const auto& tile : row) {
-      if (tile.texture_name != "") {
-        DrawTexture(asset_manager_.getTexture(tile.texture_name), tile.x,
-                    tile.y, WHITE);
+void TileMap::draw(RenderCommandList& commands, const Rectangle& view) const {
+  const TileRange range = getVisibleTiles(view);
+  if (range.start_x == range.end_x || range.start_y == range.end_y) return;
+  for (size_t chunk_y = range.start_y / kLevelChunkSize;
+       chunk_y <= (range.end_y - 1) / kLevelChunkSize; ++chunk_y) {
+    const size_t base_y = chunk_y * kLevelChunkSize;
+    const size_t start_row = std::max(range.start_y, base_y) - base_y;
+    const size_t end_row =
+        std::min<size_t>(range.end_y, base_y + kLevelChunkSize) - base_y;
+    for (size_t chunk_x = range.start_x / kLevelChunkSize;
+         chunk_x <= (range.end_x - 1) / kLevelChunkSize; ++chunk_x) {
+      const Chunk* chunk = chunks_[chunk_y * num_chunks_x_ + chunk_x].get();
+      if (!chunk) continue;
+      // Mask off the columns of this chunk outside the view
+      const size_t base_x = chunk_x * kLevelChunkSize;
+      const size_t start_column = std::max(range.start_x, base_x) - base_x;
+      const size_t end_column =
+          std::min<size_t>(range.end_x, base_x + kLevelChunkSize) - base_x;
+      const uint64_t columns =
+          (kChunkRowMask >> (kLevelChunkSize - (end_column - start_column)))
+          << start_column;
+      for (size_t row = start_row; row < end_row; ++row) {
+        // Draw in the placed tiles, walking only the set bits
+        for (uint64_t bits = getChunkRow(*chunk, row) & columns; bits != 0;
+             bits &= bits - 1) {
+          const size_t column = std::countr_zero(bits);
+          commands.drawTexture(
+              asset_manager_.getTexture(
+                  getTexture(chunk->tiles[row * kLevelChunkSize + column])),
+              origin_x_ + (base_x + column) * kTileSize,
+              origin_y_ + (base_y + row) * kTileSize, WHITE);
+        }
       }
     }
   }
 }
 
+TileRange TileMap::getVisibleTiles(const Rectangle& view) const {
+  const float left = std::floor((view.x - origin_x_) / kTileSize);
+  const float top = std::floor((view.y - origin_y_) / kTileSize);
+  const float right = std::ceil((view.x + view.width - origin_x_) / kTileSize);
+  const float bottom =
+      std::ceil((view.y + view.height - origin_y_) / kTileSize);
+  if (right <= 0 || bottom <= 0 || left >= max_tiles_x_ ||
+      top >= max_tiles_y_) {
+    return TileRange{0, 0, 0, 0};
+  }
+  return TileRange{static_cast<size_t>(std::max(left, 0.0f)),
+                   static_cast<size_t>(std::max(top, 0.0f)),
+                   std::min(static_cast<size_t>(right), max_tiles_x_),
+                   std::min(static_cast<size_t>(bottom), max_tiles_y_)};
+}
+
 bool TileMap::isInBounds(size_t tile_x, size_t tile_y) const {
-  if (tile_x > max_tiles_x_ || tile_y > max_tiles_y_) {
+  if (tile_x >= max_tiles_x_ || tile_y >= max_tiles_y_) {
     return false;
   }
   return true;
 }
 
+LevelTileId TileMap::getCell(size_t tile_x, size_t tile_y) const {
+  const Chunk* chunk = findChunk(tile_x, tile_y);
+  return chunk ? chunk->tiles[getChunkCell(tile_x, tile_y)] : kEmptyLevelTile;
+}
+
+void TileMap::fillRow(size_t start_x, size_t end_x, size_t tile_y,
+                      LevelTileId id) {
+  for (size_t x = start_x; x < end_x;) {
+    const size_t chunk_x = x / kLevelChunkSize;
+    const size_t start_column = x % kLevelChunkSize;
+    const size_t count =
+        std::min<size_t>(end_x - x, kLevelChunkSize - start_column);
+    x += count;
+    std::unique_ptr<Chunk>& chunk =
+        chunks_[(tile_y / kLevelChunkSize) * num_chunks_x_ + chunk_x];
+    if (!chunk) {
+      if (id == kEmptyLevelTile) continue;
+      chunk = std::make_unique<Chunk>();
+      ++num_allocated_chunks_;
+    }
+    LevelTileId* tiles = chunk->tiles.data() +
+                         (tile_y % kLevelChunkSize) * kLevelChunkSize +
+                         start_column;
+    bool changed{false};
+    for (size_t i = 0; i < count; ++i) {
+      changed |= tiles[i] != id;
+      tiles[i] = id;
+    }
+    if (!changed) continue;
+    const uint64_t columns = (kChunkRowMask >> (kLevelChunkSize - count))
+                             << start_column;
+    updateChunkRow(chunk, chunk_x, tile_y, columns,
+                   id == kEmptyLevelTile ? 0 : columns);
+  }
+}
+
+void TileMap::writeRow(size_t start_x, size_t tile_y,
+                       std::span<const LevelTileId> ids) {
+  const size_t end_x = start_x + ids.size();
+  for (size_t x = start_x; x < end_x;) {
+    const size_t chunk_x = x / kLevelChunkSize;
+    const size_t start_column = x % kLevelChunkSize;
+    const size_t count =
+        std::min<size_t>(end_x - x, kLevelChunkSize - start_column);
+    const LevelTileId* source = ids.data() + (x - start_x);
+    x += count;
+    uint64_t placed{0};
+    for (size_t i = 0; i < count; ++i) {
+      placed |= uint64_t{source[i] != kEmptyLevelTile} << (start_column + i);
+    }
+    std::unique_ptr<Chunk>& chunk =
+        chunks_[(tile_y / kLevelChunkSize) * num_chunks_x_ + chunk_x];
+    if (!chunk) {
+      if (placed == 0) continue;
+      chunk = std::make_unique<Chunk>();
+      ++num_allocated_chunks_;
+    }
+    LevelTileId* tiles = chunk->tiles.data() +
+                         (tile_y % kLevelChunkSize) * kLevelChunkSize +
+                         start_column;
+    if (std::equal(source, source + count, tiles)) continue;
+    std::copy(source, source + count, tiles);
+    const uint64_t columns = (kChunkRowMask >> (kLevelChunkSize - count))
+                             << start_column;
+    updateChunkRow(chunk, chunk_x, tile_y, columns, placed);
+  }
+}
+
+void TileMap::updateChunkRow(std::unique_ptr<Chunk>& chunk, size_t chunk_x,
+                             size_t tile_y, uint64_t columns,
+                             uint64_t placed) {
+  const size_t row = tile_y % kLevelChunkSize;
+  const size_t shift = row % kChunkRowsPerWord * kLevelChunkSize;
+  uint64_t& word = chunk->occupied[row / kChunkRowsPerWord];
+  const uint64_t before = getChunkRow(*chunk, row) & columns;
+  word = (word & ~(columns << shift)) | (placed << shift);
+  chunk->num_tiles += std::popcount(placed);
+  chunk->num_tiles -= std::popcount(before);
+  markDirty(chunk_x * kLevelChunkSize, tile_y);
+  if (chunk->num_tiles == 0) {
+    chunk.reset();
+    --num_allocated_chunks_;
+  }
+}
+
+uint64_t TileMap::getMatchingCells(size_t chunk_x, size_t tile_y,
+                                   LevelTileId id) const {
+  const size_t base_x = chunk_x * kLevelChunkSize;
+  const Chunk* chunk = findChunk(base_x, tile_y);
+  const size_t row = tile_y % kLevelChunkSize;
+  uint64_t cells{0};
+  if (!chunk) {
+    cells = id == kEmptyLevelTile ? kChunkRowMask : 0;
+  } else if (id == kEmptyLevelTile) {
+    cells = ~getChunkRow(*chunk, row) & kChunkRowMask;
+  } else {
+    const LevelTileId* tiles = chunk->tiles.data() + row * kLevelChunkSize;
+    for (size_t x = 0; x < kLevelChunkSize; ++x) {
+      cells |= uint64_t{tiles[x] == id} << x;
+    }
+  }
+  // The last chunk can hang over the map's edge
+  if (base_x + kLevelChunkSize > max_tiles_x_) {
+    cells &= kChunkRowMask >> (base_x + kLevelChunkSize - max_tiles_x_);
+  }
+  return cells;
+}
+
+size_t TileMap::findCell(size_t start_x, size_t end_x, size_t tile_y,
+                         LevelTileId id) const {
+  for (size_t x = start_x; x < end_x;) {
+    const size_t chunk_x = x / kLevelChunkSize;
+    const uint64_t cells = getMatchingCells(chunk_x, tile_y, id) >>
+                           (x % kLevelChunkSize) << (x % kLevelChunkSize);
+    if (cells != 0) {
+      return std::min(chunk_x * kLevelChunkSize + std::countr_zero(cells),
+                      end_x);
+    }
+    x = (chunk_x + 1) * kLevelChunkSize;
+  }
+  return end_x;
+}
+
+size_t TileMap::getRunStart(size_t tile_x, size_t tile_y,
+                            LevelTileId id) const {
+  size_t start_x = tile_x;
+  while (start_x > 0) {
+    const size_t chunk_x = (start_x - 1) / kLevelChunkSize;
+    // Cells of this chunk left of start_x, moved to the top bits
+    const size_t left = start_x - chunk_x * kLevelChunkSize;
+    const size_t run =
+        std::countl_one(getMatchingCells(chunk_x, tile_y, id) << (64 - left));
+    start_x -= run;
+    if (run < left) break;
+  }
+  return start_x;
+}
+
+size_t TileMap::getRunEnd(size_t tile_x, size_t tile_y, LevelTileId id) const {
+  size_t end_x = tile_x;
+  while (end_x < max_tiles_x_) {
+    const size_t column = end_x % kLevelChunkSize;
+    const size_t run = std::countr_one(
+        getMatchingCells(end_x / kLevelChunkSize, tile_y, id) >> column);
+    end_x += run;
+    if (run < kLevelChunkSize - column) break;
+  }
+  return end_x;
+}
+
+void TileMap::pushFillSpan(size_t start_x, size_t end_x, size_t tile_y,
+                           int dy) {
+  if ((dy < 0 && tile_y == 0) || (dy > 0 && tile_y + 1 == max_tiles_y_)) {
+    return;
+  }
+  fill_spans_.push_back(FillSpan{start_x, end_x, tile_y + dy, dy});
+}
+
+void TileMap::clearDirty() {
+  std::fill(dirty_chunks_.begin(), dirty_chunks_.end(), 0);
+  num_dirty_chunks_ = 0;
+}
+
+void TileMap::markDirty(size_t tile_x, size_t tile_y) {
+  uint8_t& dirty = dirty_chunks_[(tile_y / kLevelChunkSize) * num_chunks_x_ +
+                                 tile_x / kLevelChunkSize];
+  num_dirty_chunks_ += dirty == 0;
+  dirty = 1;
+}
+
+LevelTileId TileMap::getTileId(TextureHandle texture) {
+  if (texture >= palette_ids_.size()) {
+    palette_ids_.resize(texture + 1, kEmptyLevelTile);
+  }
+  if (palette_ids_[texture] == kEmptyLevelTile) {
+    palette_.push_back(texture);
+    palette_ids_[texture] = static_cast<LevelTileId>(palette_.size());
+  }
+  return palette_ids_[texture];
+}
+
 }  // namespace platformer2d
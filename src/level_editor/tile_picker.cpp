@@ -11,26 +11,26 @@ constexpr size_t kPickerNumTilesY =
 
 TilePicker::TilePicker(AssetManager& asset_manager)
     : asset_manager_{asset_manager},
-      current_texture_name_("tile_winter_ice"),
-      tile_map_{kPickerNumTilesX, kPickerNumTilesY, asset_manager} {}
+      current_texture_{kInvalidTexture},
+      tile_map_{kPickerNumTilesX, kPickerNumTilesY, asset_manager,
+                left_border_x, top_border_y} {}
 
 void TilePicker::init() {
   // Loop through assets and write each tile to the tilemap
   // For now we will ignore sprites
   // Note the first one is black so we can use it as a delete
   // tile thus we start with x=1 not 0
+  current_texture_ = asset_manager_.getHandle("tile_winter_ice");
   size_t count_x = 1;
   size_t count_y = 0;
-  for (auto& asset_it : asset_manager_.getTextures()) {
-    auto& texture_name = asset_it.first;
+  const auto& textures = asset_manager_.getTextures();
+  for (size_t handle = 0; handle < textures.size(); ++handle) {
     // Only load tiles in right now. Ignore sprites
-    if (!texture_name.starts_with("tile_")) {
+    if (!textures[handle].name.starts_with("tile_")) {
       continue;
     }
-    const float pos_x = (count_x * kTileSize) + left_border_x;
-    const float pos_y = (count_y * kTileSize) + top_border_y;
-    bool added =
-        tile_map_.addTile(count_x, count_y, pos_x, pos_y, texture_name);
+    bool added = tile_map_.addTile(count_x, count_y,
+                                   static_cast<TextureHandle>(handle));
     if (!added) {
       PANIC("Attempted to place tile out of bounds");
     }
@@ -45,25 +45,24 @@ void TilePicker::init() {
   }
 }
 
-void TilePicker::draw() const {
+void TilePicker::draw(RenderCommandList& commands) const {
   // Draw title
-  DrawText("Tile Picker", (int)left_border_x + 10, (int)top_border_y - 30, 15,
-           BLACK);
+  commands.drawText("Tile Picker", (int)left_border_x + 10,
+                    (int)top_border_y - 30, 15, BLACK);
   // Borders for the tile picker
-  DrawLineEx(Vector2{left_border_x, top_border_y},
-             Vector2{right_border_x, top_border_y}, 2, BLACK);
-  DrawLineEx(Vector2{left_border_x, bottom_border_y},
-             Vector2{right_border_x, bottom_border_y}, 2, BLACK);
-  DrawLineEx(Vector2{left_border_x, kScreenHeight}, Vector2{left_border_x, 0},
-             2, BLACK);
-  DrawLineEx(Vector2{right_border_x - 1, kScreenHeight},
-             Vector2{right_border_x - 1, 0}, 2, BLACK);
+  commands.drawLine(Vector2{left_border_x, top_border_y},
+                    Vector2{right_border_x, top_border_y}, 2, BLACK);
+  commands.drawLine(Vector2{left_border_x, bottom_border_y},
+                    Vector2{right_border_x, bottom_border_y}, 2, BLACK);
+  commands.drawLine(Vector2{left_border_x, kScreenHeight},
+                    Vector2{left_border_x, 0}, 2, BLACK);
+  commands.drawLine(Vector2{right_border_x - 1, kScreenHeight},
+                    Vector2{right_border_x - 1, 0}, 2, BLACK);
 
-  tile_map_.draw();
+  tile_map_.draw(commands);
 }
 
-void TilePicker::setCurrentTextureName(int mouse_x, int mouse_y) {
-  DLOG("Mouse x: " << mouse_x << " Mouse y: " << mouse_y);
+void TilePicker::setCurrentTexture(int mouse_x, int mouse_y) {
   // Find the position in tile map
   size_t count_x = (mouse_x - left_border_x) / kTileSize;
   size_t count_y = (mouse_y - top_border_y) / kTileSize;
@@ -71,12 +70,11 @@ void TilePicker::setCurrentTextureName(int mouse_x, int mouse_y) {
   if (!tile) {
     PANIC("Out of bounds error selecting tile");
   }
-  DLOG("Setting current texture name: " << tile->get().texture_name);
-  current_texture_name_ = tile->get().texture_name;
+  current_texture_ = tile->texture;
 }
 
-std::string TilePicker::getCurrentTextureName() const {
-  return current_texture_name_;
+TextureHandle TilePicker::getCurrentTexture() const {
+  return current_texture_;
 }
 
 }  // namespace platformer2d
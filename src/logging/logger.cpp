@@ -0,0 +1,173 @@
+#include "logging/logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "threading/spsc_queue.h"
+
+namespace platformer2d {
+
+// How long the writer sleeps between drains unless woken by a warning
+constexpr std::chrono::milliseconds kLogWriteInterval{10};
+
+// Forward declare free helpers
+const char* getLogLevelName(LogLevel level);
+
+struct Logger::ThreadBuffer {
+  SpscQueue<Line, kLogLinesPerThread> lines;
+  std::atomic<size_t> dropped{0};
+  // False once the thread exits so the buffer can go to a new thread
+  bool in_use{false};
+  LogLineBuffer text;
+  std::ostream stream{&text};
+};
+
+struct Logger::ThreadSlot {
+  ThreadBuffer* buffer{nullptr};
+  ~ThreadSlot() {
+    if (buffer == nullptr) return;
+    // Written out first so the next thread given the buffer starts with an
+    // empty ring
+    Logger& logger = Logger::get();
+    logger.flush();
+    std::lock_guard<std::mutex> lock{logger.buffers_mutex_};
+    buffer->in_use = false;
+  }
+};
+
+thread_local Logger::ThreadBuffer* Logger::thread_buffer_{nullptr};
+
+Logger& Logger::get() {
+  // Never destroyed so lines logged from other static destructors still go
+  // somewhere, the atexit hook writes out what is left
+  alignas(Logger) static unsigned char storage[sizeof(Logger)];
+  static Logger* logger = new (storage) Logger;
+  return *logger;
+}
+
+Logger::Logger() {
+  writer_ = std::thread(&Logger::writerLoop, this);
+  std::atexit(flushAtExit);
+}
+
+std::ostream& Logger::beginLine() {
+  ThreadBuffer& buffer = getThreadBuffer();
+  buffer.text.reset();
+  buffer.stream.clear();
+  return buffer.stream;
+}
+
+void Logger::endLine(LogLevel level) {
+  ThreadBuffer& buffer = getThreadBuffer();
+  Line line;
+  line.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now().time_since_epoch())
+                     .count();
+  line.level = level;
+  line.length = buffer.text.getLength();
+  std::copy_n(buffer.text.getText(), line.length, line.text);
+  if (!buffer.lines.tryPush(line)) {
+    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+  // Past exit nothing drains the rings any more
+  if (stopping_.load(std::memory_order_relaxed)) {
+    flush();
+  } else if (level >= LogLevel::kWarning) {
+    wake_.notify_one();
+  }
+}
+
+void Logger::flush() {
+  std::lock_guard<std::mutex> lock{consumer_mutex_};
+  writePending();
+}
+
+Logger::ThreadBuffer& Logger::getThreadBuffer() {
+  if (thread_buffer_ != nullptr) {
+    return *thread_buffer_;
+  }
+  // Only constructed on a thread that logs, its destructor runs when the
+  // thread exits
+  thread_local ThreadSlot slot;
+  std::lock_guard<std::mutex> lock{buffers_mutex_};
+  auto it = std::find_if(buffers_.begin(), buffers_.end(),
+                         [](const auto& buffer) { return !buffer->in_use; });
+  if (it == buffers_.end()) {
+    buffers_.push_back(std::make_unique<ThreadBuffer>());
+    it = buffers_.end() - 1;
+  }
+  thread_buffer_ = it->get();
+  thread_buffer_->in_use = true;
+  slot.buffer = thread_buffer_;
+  return *thread_buffer_;
+}
+
+void Logger::writerLoop() {
+  while (!stopping_.load(std::memory_order_relaxed)) {
+    {
+      std::unique_lock<std::mutex> lock{wake_mutex_};
+      wake_.wait_for(lock, kLogWriteInterval);
+    }
+    flush();
+  }
+}
+
+void Logger::writePending() {
+  size_t dropped{0};
+  {
+    std::lock_guard<std::mutex> lock{buffers_mutex_};
+    Line line;
+    for (auto& buffer : buffers_) {
+      while (buffer->lines.tryPop(line)) {
+        pending_.push_back(line);
+      }
+      dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+    }
+  }
+  if (pending_.empty() && dropped == 0) return;
+
+  // Each ring is in order already, this interleaves the threads
+  std::stable_sort(pending_.begin(), pending_.end(),
+                   [](const Line& a, const Line& b) {
+                     return a.time_ns < b.time_ns;
+                   });
+  for (const auto& line : pending_) {
+    std::fprintf(line.level >= LogLevel::kWarning ? stderr : stdout,
+                 "%s: %.*s\n", getLogLevelName(line.level), (int)line.length,
+                 line.text);
+  }
+  if (dropped > 0) {
+    std::fprintf(stderr, "WARNING: %zu log lines dropped\n", dropped);
+  }
+  std::fflush(stdout);
+  std::fflush(stderr);
+  pending_.clear();
+}
+
+void Logger::flushAtExit() {
+  Logger& logger = Logger::get();
+  logger.stopping_.store(true, std::memory_order_relaxed);
+  logger.wake_.notify_one();
+  logger.writer_.join();
+  logger.flush();
+}
+
+// Free helper Methods
+const char* getLogLevelName(LogLevel level) {
+  switch (level) {
+    case LogLevel::kDebug:
+      return "DEBUG";
+    case LogLevel::kInfo:
+      return "INFO";
+    case LogLevel::kWarning:
+      return "WARNING";
+    case LogLevel::kError:
+      return "ERROR";
+  }
+  return "LOG";
+}
+
+}  // namespace platformer2d
@@ -1,15 +1,325 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
 #include "game.h"
+#include "game_loop.h"
+#include "logging/logger.h"
+#include "managers/input_recording.h"
+#include "managers/input_script.h"
+#include "profiling/allocation_tracker.h"
+#include "profiling/profiler.h"
 #include "raylib.h"
+#include "render/null_render_backend.h"
 
 using namespace platformer2d;
 
-int main() {
-  Game game{};
+// The headless target is the same program that defaults to --headless
+#ifdef PLATFORMER2D_HEADLESS
+constexpr bool kHeadlessBuild{true};
+#else
+constexpr bool kHeadlessBuild{false};
+#endif
+
+// Frames before this are still loading so may allocate
+constexpr size_t kAllocationWarmupFrames{60};
 
-  while (!WindowShouldClose()) {
-    game.update();
-    game.draw();
+void printUsage(const char* program) {
+  std::cerr << "Usage: " << program << " [options]\n"
+            << "  --headless            Run without a window\n"
+            << "  --threaded            Simulate on a separate thread\n"
+            << "  --texture-budget-mb N Limit resident texture memory\n"
+            << "  --metrics FILE        Write frame metrics as CSV\n"
+            << "  --record-input FILE   Save every tick's input (threaded or\n"
+            << "                        headless)\n"
+            << "  --replay-input FILE   Play back recorded input (threaded or\n"
+            << "                        headless)\n"
+            << "  --fast-forward        Threaded: replay without waiting\n"
+            << "                        between ticks\n"
+            << "  --ticks N             Headless: number of fixed steps\n"
+            << "  --input-script FILE   Headless: scripted input\n"
+            << "  --record-frames FILE  Headless: write render commands\n"
+            << "  --no-draw             Headless: skip building frames\n"
+            << "  --profile-trace FILE  Headless: write a Chrome trace\n"
+            << "  --max-frame-allocations N\n"
+            << "                        Headless: fail if a frame after the\n"
+            << "                        first " << kAllocationWarmupFrames
+            << " allocates more\n";
+}
+
+// Returns false if path is set and the recording could not be saved to it
+bool saveRecordedInput(const InputRecording& recording,
+                       const std::string& path) {
+  if (path.empty()) return true;
+  if (!recording.saveToFile(path)) {
+    std::cerr << "Could not write " << path << std::endl;
+    return false;
+  }
+  std::cout << "recorded input: " << recording.getTickCount() << " ticks"
+            << std::endl;
+  return true;
+}
+
+#ifdef PLATFORMER2D_TRACK_ALLOCATIONS
+// Returns false if a frame after the warm up made more than max_per_frame
+// allocations
+bool reportAllocations(std::optional<uint64_t> max_per_frame) {
+  const AllocationTracker& tracker = AllocationTracker::get();
+  const std::vector<uint64_t>& counts = tracker.getFrameCounts();
+  uint64_t total{0};
+  uint64_t worst{0};
+  size_t worst_frame{0};
+  for (size_t frame = kAllocationWarmupFrames; frame < counts.size();
+       ++frame) {
+    total += counts[frame];
+    if (counts[frame] > worst) {
+      worst = counts[frame];
+      worst_frame = frame;
+    }
+  }
+  const size_t num_frames =
+      counts.size() > kAllocationWarmupFrames
+          ? counts.size() - kAllocationWarmupFrames
+          : 0;
+  std::cout << "allocations per frame after " << kAllocationWarmupFrames
+            << ": avg " << (num_frames > 0 ? (double)total / num_frames : 0)
+            << " max " << worst << " (frame " << worst_frame << ")\n"
+            << "top allocation sites (whole run):\n";
+  const std::vector<AllocationSite>& sites = tracker.getTotalSites();
+  for (size_t i = 0; i < std::min<size_t>(sites.size(), 5); ++i) {
+    std::cout << "  " << sites[i].zone << ": " << sites[i].count
+              << " allocations " << sites[i].bytes << " bytes\n";
+  }
+  std::cout << std::flush;
+  if (max_per_frame && worst > *max_per_frame) {
+    std::cerr << "Frame " << worst_frame << " made " << worst
+              << " allocations, the limit is " << *max_per_frame << std::endl;
+    return false;
+  }
+  return true;
+}
+#endif
+
+int runHeadlessFromArgs(const HeadlessOptions& base_options,
+                        const std::string& input_script_path,
+                        const std::string& record_frames_path,
+                        const std::string& profile_trace_path,
+                        std::optional<uint64_t> max_frame_allocations,
+                        const std::string& metrics_path,
+                        size_t texture_budget) {
+  HeadlessOptions options{base_options};
+  InputScript input_script;
+  if (!input_script_path.empty() && options.replay_input != nullptr) {
+    std::cerr << "Use either an input script or a replay, not both"
+              << std::endl;
+    return 1;
+  }
+  if (!input_script_path.empty()) {
+    if (!input_script.loadFromFile(input_script_path)) {
+      std::cerr << "Could not load input script " << input_script_path
+                << std::endl;
+      return 1;
+    }
+    options.input_script = &input_script;
+  }
+
+  std::ofstream record_file;
+  if (!record_frames_path.empty()) {
+    record_file.open(record_frames_path);
+    if (!record_file.is_open()) {
+      std::cerr << "Could not open " << record_frames_path << std::endl;
+      return 1;
+    }
+  }
+
+  // Only warnings and errors from raylib, it is chatty about every image
+  SetTraceLogLevel(LOG_WARNING);
+  Game game{GameMode::kHeadless};
+  game.setTextureBudget(texture_budget);
+  if (!metrics_path.empty() && !game.openMetricsDump(metrics_path)) {
+    std::cerr << "Could not open " << metrics_path << std::endl;
+    return 1;
+  }
+  auto backend = std::make_unique<NullRenderBackend>(
+      record_file.is_open() ? &record_file : nullptr);
+  const NullRenderBackend& null_backend = *backend;
+  game.setRenderBackend(std::move(backend));
+
+#ifdef PLATFORMER2D_PROFILE
+  if (!profile_trace_path.empty()) {
+    Profiler::get().startCapture();
+  }
+#else
+  if (!profile_trace_path.empty()) {
+    std::cerr << "Built without PLATFORMER2D_PROFILE, no trace to write"
+              << std::endl;
+    return 1;
+  }
+#endif
+#ifndef PLATFORMER2D_TRACK_ALLOCATIONS
+  if (max_frame_allocations) {
+    std::cerr << "Built without PLATFORMER2D_TRACK_ALLOCATIONS, allocations "
+                 "are not counted"
+              << std::endl;
+    return 1;
+  }
+#endif
+  const HeadlessReport report = runHeadless(game, options);
+  // Everything logged during the run comes before the report
+  Logger::get().flush();
+#ifdef PLATFORMER2D_PROFILE
+  if (!profile_trace_path.empty() &&
+      !Profiler::get().stopCapture(profile_trace_path)) {
+    std::cerr << "Could not write " << profile_trace_path << std::endl;
+    return 1;
+  }
+#endif
+  std::cout << "ticks: " << report.ticks << "\n"
+            << "simulated seconds: " << report.simulated_seconds << "\n"
+            << "wall seconds: " << report.wall_seconds << "\n"
+            << "speedup: "
+            << (report.wall_seconds > 0
+                    ? report.simulated_seconds / report.wall_seconds
+                    : 0)
+            << "x\n"
+            << "render commands: " << null_backend.getStats().commands << "\n";
+  const TextureStats& textures = game.getTextureStats();
+  std::cout << "texture bytes resident: " << textures.resident_bytes
+            << " peak: " << textures.peak_resident_bytes << "\n"
+            << "texture hits: " << textures.hits
+            << " misses: " << textures.misses
+            << " evictions: " << textures.evictions << std::endl;
+#ifdef PLATFORMER2D_TRACK_ALLOCATIONS
+  if (!reportAllocations(max_frame_allocations)) {
+    return 1;
+  }
+#endif
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  bool headless{kHeadlessBuild};
+  bool threaded{false};
+  bool fast_forward{false};
+  HeadlessOptions options;
+  std::optional<uint64_t> ticks;
+  std::string input_script_path;
+  std::string record_frames_path;
+  std::string profile_trace_path;
+  std::optional<uint64_t> max_frame_allocations;
+  std::string metrics_path;
+  std::string record_input_path;
+  std::string replay_input_path;
+  size_t texture_budget{0};
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg{argv[i]};
+    const bool has_value = i + 1 < argc;
+    if (arg == "--headless") {
+      headless = true;
+    } else if (arg == "--threaded") {
+      threaded = true;
+    } else if (arg == "--texture-budget-mb" && has_value) {
+      texture_budget = std::strtod(argv[++i], nullptr) * 1024 * 1024;
+    } else if (arg == "--metrics" && has_value) {
+      metrics_path = argv[++i];
+    } else if (arg == "--record-input" && has_value) {
+      record_input_path = argv[++i];
+    } else if (arg == "--replay-input" && has_value) {
+      replay_input_path = argv[++i];
+    } else if (arg == "--fast-forward") {
+      fast_forward = true;
+    } else if (arg == "--ticks" && has_value) {
+      ticks = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--input-script" && has_value) {
+      input_script_path = argv[++i];
+    } else if (arg == "--record-frames" && has_value) {
+      record_frames_path = argv[++i];
+    } else if (arg == "--profile-trace" && has_value) {
+      profile_trace_path = argv[++i];
+    } else if (arg == "--max-frame-allocations" && has_value) {
+      max_frame_allocations = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--no-draw") {
+      options.draw = false;
+    } else {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  // Replays need the fixed timestep they were recorded with, the windowed
+  // loop steps by however long the last frame took
+  const bool uses_recording =
+      !record_input_path.empty() || !replay_input_path.empty();
+  if (uses_recording && !headless && !threaded) {
+    std::cerr << "Recording and replaying input needs --threaded or "
+                 "--headless"
+              << std::endl;
+    return 1;
+  }
+  InputRecording replay_input;
+  if (!replay_input_path.empty()) {
+    if (!replay_input.loadFromFile(replay_input_path)) {
+      std::cerr << "Could not load input recording " << replay_input_path
+                << std::endl;
+      return 1;
+    }
+    if (!headless && replay_input.getTimestep() != kFixedTimestep) {
+      std::cerr << replay_input_path << " was recorded with a "
+                << replay_input.getTimestep()
+                << "s timestep, threaded runs step by " << kFixedTimestep
+                << "s" << std::endl;
+      return 1;
+    }
+    options.replay_input = &replay_input;
+    options.timestep = replay_input.getTimestep();
+    options.ticks = replay_input.getTickCount();
+  }
+  if (ticks) {
+    options.ticks = *ticks;
+  }
+  InputRecording record_input;
+  if (!record_input_path.empty()) {
+    record_input.reset(headless ? options.timestep : kFixedTimestep);
+    options.record_input = &record_input;
+  }
+
+  if (headless) {
+    const int result = runHeadlessFromArgs(
+        options, input_script_path, record_frames_path, profile_trace_path,
+        max_frame_allocations, metrics_path, texture_budget);
+    if (!saveRecordedInput(record_input, record_input_path)) {
+      return 1;
+    }
+    return result;
+  }
+
+  if (threaded) {
+    Game game{GameMode::kThreaded};
+    game.setTextureBudget(texture_budget);
+    if (!metrics_path.empty() && !game.openMetricsDump(metrics_path)) {
+      std::cerr << "Could not open " << metrics_path << std::endl;
+      return 1;
+    }
+    ThreadedOptions threaded_options;
+    threaded_options.record_input = options.record_input;
+    threaded_options.replay_input = options.replay_input;
+    threaded_options.fast_forward = fast_forward;
+    runThreaded(game, threaded_options);
+    return saveRecordedInput(record_input, record_input_path) ? 0 : 1;
+  }
+
+  Game game{};
+  game.setTextureBudget(texture_budget);
+  if (!metrics_path.empty() && !game.openMetricsDump(metrics_path)) {
+    std::cerr << "Could not open " << metrics_path << std::endl;
+    return 1;
   }
+  runWindowed(game);
 
   return 0;
 }
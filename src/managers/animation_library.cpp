@@ -0,0 +1,207 @@
+#include "managers/animation_library.h"
+
+#include <fstream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "debug.h"
+#include "nlohmann/json.hpp"
+#include "profiling/profiler.h"
+
+namespace platformer2d {
+
+// Forward declare free helpers
+bool parseCondition(const std::string& condition, AnimationTransition& into);
+
+bool AnimationLibrary::loadFromFile(const std::string& path,
+                                    AssetManager& assets) {
+  PROFILE_SCOPE("AnimationLibrary::loadFromFile");
+  std::ifstream file{path};
+  if (!file.is_open()) {
+    DLOG("Failed to open animation clip file: " << path);
+    return false;
+  }
+  const nlohmann::json json = nlohmann::json::parse(file, nullptr, false);
+  if (json.is_discarded() || !json.contains("clips")) {
+    DLOG("Malformed animation clip file: " << path);
+    return false;
+  }
+  for (const auto& clip_json : json["clips"]) {
+    const uint16_t num_frames = clip_json["num_frames"];
+    std::vector<float> frame_durations;
+    if (clip_json.contains("frame_durations")) {
+      frame_durations = clip_json["frame_durations"].get<std::vector<float>>();
+    } else {
+      frame_durations.assign(num_frames,
+                             clip_json["frame_duration"].get<float>());
+    }
+    // Frames only need the size, the pixels load in the background
+    const TextureHandle texture = assets.getHandle(clip_json["texture"]);
+    assets.acquireTexture(texture);
+    const Texture2D& size = assets.peekTexture(texture);
+    addClip(clip_json["name"].get<std::string>(), texture,
+            Vector2{(float)size.width, (float)size.height}, num_frames,
+            frame_durations);
+  }
+  return true;
+}
+
+AnimationClipId AnimationLibrary::addClip(
+    const std::string& name, TextureHandle texture, Vector2 texture_size,
+    uint16_t num_frames, const std::vector<float>& frame_durations) {
+  CHECK(!clip_ids_.contains(name), "Duplicate animation clip " + name);
+  CHECK(num_frames > 0 && frame_durations.size() == num_frames,
+        "Animation clip " + name + " needs one duration per frame");
+  for (float duration : frame_durations) {
+    CHECK(duration > 0, "Animation clip " + name + " has a zero duration");
+  }
+  CHECK(clips_.size() < kInvalidAnimationClip, "Too many animation clips");
+
+  // Frames are laid out left to right across the texture
+  CHECK(texture_size.x > 0, "Animation clip " + name + " has no texture size");
+  AnimationClip clip{texture, static_cast<uint32_t>(frames_.size()),
+                     num_frames};
+  const float frame_width = texture_size.x / num_frames;
+  for (uint16_t i = 0; i < num_frames; ++i) {
+    frames_.push_back(AnimationFrame{
+        Rectangle{i * frame_width, 0, frame_width, texture_size.y},
+        frame_durations[i]});
+  }
+
+  const AnimationClipId id = static_cast<AnimationClipId>(clips_.size());
+  clips_.push_back(clip);
+  clip_ids_.emplace(name, id);
+  return id;
+}
+
+bool AnimationLibrary::loadStateMachinesFromFile(const std::string& path) {
+  PROFILE_SCOPE("AnimationLibrary::loadStateMachinesFromFile");
+  std::ifstream file{path};
+  if (!file.is_open()) {
+    DLOG("Failed to open animation state machine file: " << path);
+    return false;
+  }
+  const nlohmann::json json = nlohmann::json::parse(file, nullptr, false);
+  if (json.is_discarded() || !json.contains("state_machines")) {
+    DLOG("Malformed animation state machine file: " << path);
+    return false;
+  }
+
+  for (const auto& machine_json : json["state_machines"]) {
+    const std::string machine_name = machine_json["name"];
+    CHECK(!state_machine_ids_.contains(machine_name),
+          "Duplicate animation state machine " + machine_name);
+
+    // Resolve state names to indices local to this machine
+    std::unordered_map<std::string, AnimationStateIndex> state_indices;
+    std::vector<AnimationClipId> state_clips;
+    for (const auto& state_json : machine_json["states"]) {
+      CHECK(state_clips.size() <
+                std::numeric_limits<AnimationStateIndex>::max(),
+            "Too many states in " + machine_name);
+      state_indices.emplace(
+          state_json["name"].get<std::string>(),
+          static_cast<AnimationStateIndex>(state_clips.size()));
+      state_clips.push_back(getClipId(state_json["clip"].get<std::string>()));
+    }
+    auto stateIndex = [&](const std::string& state_name) {
+      auto it = state_indices.find(state_name);
+      if (it == state_indices.end()) {
+        PANIC("Unknown state " << state_name << " in " << machine_name);
+      }
+      return it->second;
+    };
+
+    // Group transitions by source state, wildcard ones go last
+    std::vector<std::vector<AnimationTransition>> outgoing(state_clips.size());
+    std::vector<AnimationTransition> from_any;
+    for (const auto& transition_json : machine_json["transitions"]) {
+      AnimationTransition transition{0, 0, stateIndex(transition_json["to"])};
+      for (const auto& condition : transition_json["when"]) {
+        if (!parseCondition(condition.get<std::string>(), transition)) {
+          DLOG("Unknown condition " << condition << " in " << machine_name);
+          return false;
+        }
+      }
+      const std::string from = transition_json["from"];
+      if (from == "*") {
+        from_any.push_back(transition);
+      } else {
+        outgoing[stateIndex(from)].push_back(transition);
+      }
+    }
+
+    // Flatten into the shared tables
+    AnimationStateMachine machine{
+        static_cast<uint32_t>(machine_states_.size()),
+        static_cast<uint16_t>(state_clips.size()),
+        stateIndex(machine_json["initial_state"])};
+    for (size_t state = 0; state < state_clips.size(); ++state) {
+      AnimationMachineState machine_state{
+          state_clips[state], static_cast<uint32_t>(transitions_.size()), 0};
+      for (const auto& transition : outgoing[state]) {
+        transitions_.push_back(transition);
+      }
+      for (const auto& transition : from_any) {
+        if (transition.to_state != state) {
+          transitions_.push_back(transition);
+        }
+      }
+      machine_state.num_transitions = static_cast<uint16_t>(
+          transitions_.size() - machine_state.first_transition);
+      machine_states_.push_back(machine_state);
+    }
+
+    state_machine_ids_.emplace(
+        machine_name,
+        static_cast<AnimationStateMachineId>(state_machines_.size()));
+    state_machines_.push_back(machine);
+  }
+  return true;
+}
+
+AnimationClipId AnimationLibrary::getClipId(const std::string& name) const {
+  auto it = clip_ids_.find(name);
+  if (it == clip_ids_.end()) {
+    PANIC("Animation clip " << name << " not in AnimationLibrary");
+  }
+  return it->second;
+}
+
+AnimationStateMachineId AnimationLibrary::getStateMachineId(
+    const std::string& name) const {
+  auto it = state_machine_ids_.find(name);
+  if (it == state_machine_ids_.end()) {
+    PANIC("Animation state machine " << name << " not in AnimationLibrary");
+  }
+  return it->second;
+}
+
+// Free helper functions
+bool parseCondition(const std::string& condition, AnimationTransition& into) {
+  const bool negated = condition.starts_with('!');
+  const std::string name = negated ? condition.substr(1) : condition;
+  uint8_t bit{0};
+  if (name == "moving") {
+    bit = kConditionMoving;
+  } else if (name == "grounded") {
+    bit = kConditionGrounded;
+  } else if (name == "facing_right") {
+    bit = kConditionFacingRight;
+  } else if (name == "rising") {
+    bit = kConditionRising;
+  } else if (name == "falling") {
+    bit = kConditionFalling;
+  } else {
+    return false;
+  }
+  into.mask |= bit;
+  if (!negated) {
+    into.value |= bit;
+  }
+  return true;
+}
+
+}  // namespace platformer2d
@@ -0,0 +1,338 @@
+#include "managers/asset_bundle.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "atomic_file.h"
+#include "debug.h"
+
+namespace platformer2d {
+
+constexpr char kBundleMagic[4]{'P', '2', 'D', 'B'};
+constexpr uint32_t kBundleVersion{1};
+constexpr size_t kBundleAlignment{16};
+
+struct BundleHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_entries;
+  uint32_t string_table_size;
+};
+static_assert(sizeof(BundleHeader) == 16);
+
+// Forward declare free helpers
+std::vector<uint8_t> compressLz(const uint8_t* src, size_t size);
+bool decompressLz(const uint8_t* src, size_t size, uint8_t* dst,
+                  size_t dst_size);
+size_t alignUp(size_t value);
+
+AssetBundle::~AssetBundle() { close(); }
+
+bool AssetBundle::open(const std::string& path) {
+  close();
+  // Everything is about to be read front to back
+  if (!file_.open(path, true)) {
+    return false;
+  }
+  const uint8_t* data = file_.data();
+  const size_t size = file_.size();
+
+  BundleHeader header;
+  if (size < sizeof(header)) {
+    DLOG("Asset bundle " << path << " is too small");
+    close();
+    return false;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  const size_t table_end =
+      sizeof(BundleHeader) + header.num_entries * sizeof(AssetBundleEntry);
+  if (std::memcmp(header.magic, kBundleMagic, sizeof(kBundleMagic)) != 0 ||
+      header.version != kBundleVersion ||
+      table_end + header.string_table_size > size) {
+    DLOG("Asset bundle " << path << " is not a valid version "
+                         << kBundleVersion << " bundle");
+    close();
+    return false;
+  }
+  entries_ = std::span<const AssetBundleEntry>(
+      reinterpret_cast<const AssetBundleEntry*>(data + sizeof(BundleHeader)),
+      header.num_entries);
+  strings_ = reinterpret_cast<const char*>(data + table_end);
+
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const AssetBundleEntry& entry = entries_[i];
+    // The size inflated pixels are allocated with comes from the file, it
+    // has to be exactly what the image needs
+    const int pixel_size =
+        GetPixelDataSize(entry.width, entry.height, (int)entry.format);
+    if ((size_t)entry.name_offset + entry.name_length >
+            header.string_table_size ||
+        (size_t)entry.path_offset + entry.path_length >
+            header.string_table_size ||
+        entry.data_offset > size ||
+        entry.stored_size > size - entry.data_offset ||
+        pixel_size <= 0 || entry.raw_size != (uint64_t)pixel_size ||
+        (entry.compression == BundleCompression::kNone &&
+         entry.stored_size != entry.raw_size) ||
+        (entry.compression != BundleCompression::kNone &&
+         entry.compression != BundleCompression::kLz)) {
+      DLOG("Asset bundle " << path << " has a corrupt entry " << i);
+      close();
+      return false;
+    }
+    entry_index_.emplace(getName(entry), i);
+  }
+  return true;
+}
+
+void AssetBundle::close() {
+  file_.close();
+  entries_ = {};
+  strings_ = nullptr;
+  entry_index_.clear();
+}
+
+const AssetBundleEntry* AssetBundle::find(std::string_view name) const {
+  auto it = entry_index_.find(name);
+  return it == entry_index_.end() ? nullptr : &entries_[it->second];
+}
+
+std::string_view AssetBundle::getName(const AssetBundleEntry& entry) const {
+  return std::string_view{strings_ + entry.name_offset, entry.name_length};
+}
+
+std::string_view AssetBundle::getSourcePath(
+    const AssetBundleEntry& entry) const {
+  return std::string_view{strings_ + entry.path_offset, entry.path_length};
+}
+
+Image AssetBundle::loadImage(const AssetBundleEntry& entry,
+                             bool& owned) const {
+  Image image{nullptr, entry.width, entry.height, 1, (int)entry.format};
+  owned = false;
+  const uint8_t* stored = file_.data() + entry.data_offset;
+  if (entry.compression == BundleCompression::kNone) {
+    image.data = const_cast<uint8_t*>(stored);
+    return image;
+  }
+  // Allocated with malloc so raylib's UnloadImage can free it
+  uint8_t* pixels = static_cast<uint8_t*>(std::malloc(entry.raw_size));
+  if (pixels == nullptr) {
+    LOG_ERROR("Out of memory inflating " << getName(entry)
+                                         << " from asset bundle");
+    return image;
+  }
+  if (!decompressLz(stored, entry.stored_size, pixels, entry.raw_size)) {
+    DLOG("Corrupt pixels for " << getName(entry) << " in asset bundle");
+    std::free(pixels);
+    return image;
+  }
+  image.data = pixels;
+  owned = true;
+  return image;
+}
+
+void AssetBundleWriter::addImage(const std::string& name,
+                                 const std::string& source_path,
+                                 int display_width, int display_height,
+                                 const Image& image, bool compress) {
+  PendingImage pending{name, source_path, AssetBundleEntry{}, {}};
+  AssetBundleEntry& entry = pending.entry;
+  entry.width = image.width;
+  entry.height = image.height;
+  entry.display_width = display_width;
+  entry.display_height = display_height;
+  entry.format = image.format;
+  entry.raw_size = GetPixelDataSize(image.width, image.height, image.format);
+
+  const uint8_t* pixels = static_cast<const uint8_t*>(image.data);
+  if (compress) {
+    pending.data = compressLz(pixels, entry.raw_size);
+  }
+  if (compress && pending.data.size() < entry.raw_size) {
+    entry.compression = BundleCompression::kLz;
+  } else {
+    entry.compression = BundleCompression::kNone;
+    pending.data.assign(pixels, pixels + entry.raw_size);
+  }
+  entry.stored_size = pending.data.size();
+  raw_bytes_ += entry.raw_size;
+  stored_bytes_ += entry.stored_size;
+  images_.push_back(std::move(pending));
+}
+
+bool AssetBundleWriter::write(const std::string& path) const {
+  // Lay out the string table and the pixel data first so every entry knows
+  // where its bytes end up
+  std::vector<AssetBundleEntry> entries;
+  std::string strings;
+  for (const auto& image : images_) {
+    AssetBundleEntry entry = image.entry;
+    entry.name_offset = strings.size();
+    entry.name_length = image.name.size();
+    strings += image.name;
+    entry.path_offset = strings.size();
+    entry.path_length = image.source_path.size();
+    strings += image.source_path;
+    entries.push_back(entry);
+  }
+  BundleHeader header;
+  std::memcpy(header.magic, kBundleMagic, sizeof(kBundleMagic));
+  header.version = kBundleVersion;
+  header.num_entries = entries.size();
+  header.string_table_size = strings.size();
+
+  size_t offset = alignUp(sizeof(BundleHeader) +
+                          entries.size() * sizeof(AssetBundleEntry) +
+                          strings.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    entries[i].data_offset = offset;
+    offset = alignUp(offset + entries[i].stored_size);
+  }
+
+  // The running game may have the bundle mapped, so it is built in memory
+  // and swapped in whole rather than truncated and rewritten
+  std::string bytes;
+  bytes.reserve(offset);
+  bytes.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  bytes.append(reinterpret_cast<const char*>(entries.data()),
+               entries.size() * sizeof(AssetBundleEntry));
+  bytes += strings;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    // Zero padding up to the aligned offset
+    bytes.resize(entries[i].data_offset, '\0');
+    bytes.append(reinterpret_cast<const char*>(images_[i].data.data()),
+                 images_[i].data.size());
+  }
+  return writeFileAtomic(path, bytes);
+}
+
+// Free helper Methods
+
+size_t alignUp(size_t value) {
+  return (value + kBundleAlignment - 1) & ~(kBundleAlignment - 1);
+}
+
+// LZ4 block format. Each sequence is a token (literal length and match
+// length nibbles), extra literal length bytes, the literals, a 2 byte match
+// offset and extra match length bytes. The last sequence is literals only.
+constexpr size_t kLzMinMatch{4};
+constexpr size_t kLzLastLiterals{5};  // Always end on literals
+constexpr size_t kLzMatchSearchLimit{12};
+constexpr size_t kLzMaxOffset{65535};
+constexpr int kLzHashBits{12};
+
+void writeLzLength(std::vector<uint8_t>& out, size_t length) {
+  for (; length >= 255; length -= 255) {
+    out.push_back(255);
+  }
+  out.push_back(static_cast<uint8_t>(length));
+}
+
+void writeLzSequence(std::vector<uint8_t>& out, const uint8_t* literals,
+                     size_t num_literals, size_t offset, size_t match_length) {
+  const size_t extra_match = match_length - kLzMinMatch;
+  const uint8_t token =
+      (std::min<size_t>(num_literals, 15) << 4) |
+      (match_length == 0 ? 0 : std::min<size_t>(extra_match, 15));
+  out.push_back(token);
+  if (num_literals >= 15) {
+    writeLzLength(out, num_literals - 15);
+  }
+  out.insert(out.end(), literals, literals + num_literals);
+  // The final literals only sequence has no match
+  if (match_length == 0) return;
+  out.push_back(offset & 0xff);
+  out.push_back(offset >> 8);
+  if (extra_match >= 15) {
+    writeLzLength(out, extra_match - 15);
+  }
+}
+
+uint32_t readLzWord(const uint8_t* at) {
+  uint32_t word;
+  std::memcpy(&word, at, sizeof(word));
+  return word;
+}
+
+std::vector<uint8_t> compressLz(const uint8_t* src, size_t size) {
+  std::vector<uint8_t> out;
+  out.reserve(size / 2);
+  // Most recent position + 1 of each hashed 4 byte sequence, 0 is empty
+  std::vector<uint32_t> table(1 << kLzHashBits, 0);
+  size_t anchor{0};
+  size_t pos{0};
+  while (size >= kLzMatchSearchLimit && pos <= size - kLzMatchSearchLimit) {
+    const uint32_t sequence = readLzWord(src + pos);
+    const uint32_t hash = (sequence * 2654435761u) >> (32 - kLzHashBits);
+    const size_t candidate = table[hash];
+    table[hash] = pos + 1;
+    if (candidate == 0 || pos - (candidate - 1) > kLzMaxOffset ||
+        readLzWord(src + candidate - 1) != sequence) {
+      ++pos;
+      continue;
+    }
+    const size_t match = candidate - 1;
+    size_t length = kLzMinMatch;
+    while (pos + length < size - kLzLastLiterals &&
+           src[match + length] == src[pos + length]) {
+      ++length;
+    }
+    writeLzSequence(out, src + anchor, pos - anchor, pos - match, length);
+    pos += length;
+    anchor = pos;
+  }
+  writeLzSequence(out, src + anchor, size - anchor, 0, 0);
+  return out;
+}
+
+bool decompressLz(const uint8_t* src, size_t size, uint8_t* dst,
+                  size_t dst_size) {
+  const uint8_t* in = src;
+  const uint8_t* in_end = src + size;
+  size_t out{0};
+  auto read_length = [&](size_t length) {
+    uint8_t byte{255};
+    while (byte == 255 && in < in_end) {
+      byte = *in++;
+      length += byte;
+    }
+    return length;
+  };
+  while (in < in_end) {
+    const uint8_t token = *in++;
+    size_t num_literals = token >> 4;
+    if (num_literals == 15) {
+      num_literals = read_length(num_literals);
+    }
+    if (num_literals > (size_t)(in_end - in) ||
+        num_literals > dst_size - out) {
+      return false;
+    }
+    std::memcpy(dst + out, in, num_literals);
+    in += num_literals;
+    out += num_literals;
+    // Only the last sequence ends without a match
+    if (in == in_end) break;
+
+    if (in_end - in < 2) return false;
+    const size_t offset = in[0] | (in[1] << 8);
+    in += 2;
+    size_t length = (token & 0x0f) + kLzMinMatch;
+    if ((token & 0x0f) == 15) {
+      length = read_length(length);
+    }
+    if (offset == 0 || offset > out || length > dst_size - out) {
+      return false;
+    }
+    // Matches may overlap what they are copying so go byte by byte
+    for (size_t i = 0; i < length; ++i, ++out) {
+      dst[out] = dst[out - offset];
+    }
+  }
+  return out == dst_size;
+}
+
+}  // namespace platformer2d
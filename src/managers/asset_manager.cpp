@@ -1,43 +1,403 @@
 #include "managers/asset_manager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
 #include "debug.h"
+#include "profiling/profiler.h"
 
 namespace platformer2d {
 
-AssetManager::AssetManager() {}
+// Textures drawn more recently than this are never evicted, so a working set
+// bigger than the budget doesn't reload the same textures every frame
+constexpr uint64_t kEvictionIdleFrames{30};
 
-// load texture at its actual size
-void AssetManager::loadTexture(const std::string& name,
-                               const std::string& filename) {
+AssetManager::AssetManager(bool headless) : headless_(headless) {}
+
+void AssetManager::registerManifest(const AssetManifest& manifest) {
+  for (const auto& asset : manifest.getEntries()) {
+    const TextureHandle handle = registerTexture(
+        asset.name, asset.path, asset.display_width, asset.display_height);
+    // Knowing the pixel size up front lets sizes be used before loading
+    TextureEntry& entry = textures_[handle];
+    if (!entry.loaded && entry.display_width == 0) {
+      entry.texture.width = asset.width;
+      entry.texture.height = asset.height;
+    }
+  }
+}
+
+bool AssetManager::mountBundle(const std::string& path) {
+  PROFILE_SCOPE("AssetManager::mountBundle");
+  // Queued requests may point into the old mapping
+  if (!requests_.empty()) {
+    finishLoading();
+  }
+  for (auto& entry : textures_) {
+    entry.bundled = nullptr;
+  }
+  if (!bundle_.open(path)) {
+    return false;
+  }
+  size_t mounted{0};
+  for (const auto& bundled : bundle_.getEntries()) {
+    const std::string source{bundle_.getSourcePath(bundled)};
+    const TextureHandle handle =
+        registerTexture(std::string{bundle_.getName(bundled)}, source,
+                        bundled.display_width, bundled.display_height);
+    TextureEntry& entry = textures_[handle];
+    if (entry.filename != source) {
+      DLOG("Ignoring stale bundled texture " << entry.name);
+      continue;
+    }
+    entry.bundled = &bundled;
+    if (!entry.loaded && entry.display_width == 0) {
+      entry.texture.width = bundled.width;
+      entry.texture.height = bundled.height;
+    }
+    ++mounted;
+  }
+  DLOG("Mounted " << mounted << " textures from " << path);
+  return true;
+}
+
+TextureHandle AssetManager::registerTexture(const std::string& name,
+                                            const std::string& filename,
+                                            int width, int height) {
   // Dont overwrite existing textures
-  if (textures_.contains(name)) return;
-  Texture2D texture = LoadTexture(filename.c_str());
-  textures_[name] = texture;
+  auto it = handles_.find(name);
+  if (it != handles_.end()) return it->second;
+  CHECK(textures_.size() < kInvalidTexture, "Too many textures");
+  TextureEntry entry;
+  entry.name = name;
+  entry.filename = filename;
+  entry.display_width = width;
+  entry.display_height = height;
+  entry.texture.width = width;
+  entry.texture.height = height;
+  const TextureHandle handle = static_cast<TextureHandle>(textures_.size());
+  textures_.push_back(entry);
+  handles_.emplace(name, handle);
+  return handle;
+}
+
+// load texture at its actual size
+TextureHandle AssetManager::loadTexture(const std::string& name,
+                                        const std::string& filename) {
+  return loadTexture(name, filename, 0, 0);
 }
 
 // Load texture and set its size
-void AssetManager::loadTexture(const std::string& name,
-                               const std::string& filename, int width,
-                               int height) {
-  if (textures_.contains(name)) return;
-  Texture2D texture = LoadTexture(filename.c_str());
-  texture.width = width;
-  texture.height = height;
-  textures_[name] = texture;
-}
-
-const Texture2D& AssetManager::getTexture(const std::string& name) const {
-  if (!textures_.contains(name)) {
+TextureHandle AssetManager::loadTexture(const std::string& name,
+                                        const std::string& filename, int width,
+                                        int height) {
+  const TextureHandle handle = registerTexture(name, filename, width, height);
+  TextureEntry& entry = textures_[handle];
+  if (!entry.loaded) {
+    loadEntry(entry);
+  }
+  return handle;
+}
+
+TextureHandle AssetManager::getHandle(const std::string& name) const {
+  const TextureHandle handle = findHandle(name);
+  if (handle == kInvalidTexture) {
     PANIC("texuture " << name
                       << " not in AssetManager.textures_ : maybe a misnamed "
                          "file or texture name?");
   }
-  return textures_.at(name);
+  return handle;
+}
+
+TextureHandle AssetManager::findHandle(const std::string& name) const {
+  auto it = handles_.find(name);
+  return it == handles_.end() ? kInvalidTexture : it->second;
+}
+
+void AssetManager::acquireTexture(TextureHandle handle) {
+  TextureEntry& entry = textures_[handle];
+  ++entry.ref_count;
+  if (!entry.loaded && !entry.queued) {
+    queueTexture(entry.name, entry.filename);
+  }
+}
+
+void AssetManager::releaseTexture(TextureHandle handle) {
+  TextureEntry& entry = textures_[handle];
+  CHECK(entry.ref_count > 0,
+        "Released texture " + entry.name + " too many times");
+  --entry.ref_count;
+}
+
+size_t AssetManager::releaseUnused() {
+  size_t released{0};
+  for (auto& entry : textures_) {
+    if (!entry.loaded || entry.ref_count > 0) continue;
+    unloadEntry(entry);
+    ++released;
+  }
+  if (released > 0) {
+    DLOG("Released " << released << " unused textures");
+  }
+  return released;
+}
+
+size_t AssetManager::reloadFile(const std::string& path) {
+  size_t reloaded{0};
+  for (auto& entry : textures_) {
+    if (entry.filename != path) continue;
+    // Bundled pixels were decoded from the old file
+    entry.bundled = nullptr;
+    if (entry.queued) {
+      finishLoading();
+    }
+    if (!entry.loaded) continue;
+    unloadEntry(entry);
+    loadEntry(entry);
+    ++reloaded;
+  }
+  if (reloaded > 0) {
+    DLOG("Reloaded " << reloaded << " textures from " << path);
+  }
+  return reloaded;
+}
+
+void AssetManager::endFrame() {
+  const uint64_t frame = frame_++;
+  if (stats_.budget_bytes == 0 ||
+      stats_.resident_bytes <= stats_.budget_bytes) {
+    return;
+  }
+  // Oldest first out of everything that hasn't been drawn recently
+  std::vector<TextureEntry*> candidates;
+  for (auto& entry : textures_) {
+    if (entry.loaded && entry.last_used_frame + kEvictionIdleFrames <= frame) {
+      candidates.push_back(&entry);
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const TextureEntry* a, const TextureEntry* b) {
+              return a->last_used_frame < b->last_used_frame;
+            });
+  for (TextureEntry* entry : candidates) {
+    if (stats_.resident_bytes <= stats_.budget_bytes) break;
+    unloadEntry(*entry);
+    ++stats_.evictions;
+  }
+}
+
+TextureHandle AssetManager::queueTexture(const std::string& name,
+                                         const std::string& filename,
+                                         int width, int height) {
+  // Workers read the request list so let the current batch finish first
+  if (!workers_.empty()) {
+    finishLoading();
+  }
+  // Start a fresh batch once the previous one has been fully uploaded
+  if (num_uploaded_ == requests_.size()) {
+    requests_.clear();
+    next_request_ = 0;
+    num_uploaded_ = 0;
+  }
+  const TextureHandle handle = registerTexture(name, filename, width, height);
+  TextureEntry& entry = textures_[handle];
+  if (entry.loaded || entry.queued) return handle;
+  entry.queued = true;
+  requests_.push_back(TextureRequest{handle, entry.filename, entry.bundled});
+  return handle;
+}
+
+void AssetManager::startLoading(unsigned int num_threads) {
+  // Already running workers pick up everything queued
+  if (!workers_.empty()) return;
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  const size_t remaining = requests_.size() - next_request_;
+  num_threads = std::min<size_t>(num_threads, remaining);
+  for (unsigned int i = 0; i < num_threads; ++i) {
+    workers_.emplace_back(&AssetManager::decodeWorker, this);
+  }
+}
+
+size_t AssetManager::uploadPendingTextures(double budget_seconds) {
+  PROFILE_SCOPE("AssetManager::uploadPendingTextures");
+  using Clock = std::chrono::steady_clock;
+  const auto deadline =
+      Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                         std::chrono::duration<double>(budget_seconds));
+  size_t uploaded{0};
+  do {
+    DecodedImage decoded;
+    {
+      std::lock_guard<std::mutex> lock{decoded_mutex_};
+      if (decoded_.empty()) break;
+      decoded = decoded_.back();
+      decoded_.pop_back();
+    }
+    uploadDecoded(decoded);
+    ++uploaded;
+  } while (Clock::now() < deadline);
+
+  if (num_uploaded_ == requests_.size()) {
+    joinWorkers();
+  }
+  return uploaded;
+}
+
+void AssetManager::finishLoading() {
+  PROFILE_SCOPE("AssetManager::finishLoading");
+  if (workers_.empty() && next_request_ < requests_.size()) {
+    startLoading();
+  }
+  while (num_uploaded_ < requests_.size()) {
+    std::vector<DecodedImage> ready;
+    {
+      std::unique_lock<std::mutex> lock{decoded_mutex_};
+      decoded_ready_.wait(lock, [this] { return !decoded_.empty(); });
+      ready.swap(decoded_);
+    }
+    for (const auto& decoded : ready) {
+      uploadDecoded(decoded);
+    }
+  }
+  joinWorkers();
+}
+
+LoadingProgress AssetManager::getLoadingProgress() const {
+  return LoadingProgress{num_uploaded_, requests_.size()};
+}
+
+void AssetManager::loadOnDemand(TextureEntry& entry) {
+  // Already on its way so wait for the batch rather than load it twice
+  if (entry.queued) {
+    finishLoading();
+  }
+  if (!entry.loaded) {
+    loadEntry(entry);
+  }
+}
+
+void AssetManager::loadEntry(TextureEntry& entry) {
+  PROFILE_SCOPE("AssetManager::loadEntry");
+  if (!headless_ && entry.bundled == nullptr) {
+    setTexture(entry, LoadTexture(entry.filename.c_str()));
+    return;
+  }
+  bool owned;
+  Image image = decodeImage(entry.filename, entry.bundled, owned);
+  setTexture(entry, textureFromImage(image));
+  if (owned) {
+    UnloadImage(image);
+  }
+}
+
+Image AssetManager::decodeImage(const std::string& filename,
+                                const AssetBundleEntry* bundled,
+                                bool& owned) const {
+  PROFILE_SCOPE("AssetManager::decodeImage");
+  if (bundled != nullptr) {
+    return bundle_.loadImage(*bundled, owned);
+  }
+  owned = true;
+  return LoadImage(filename.c_str());
+}
+
+void AssetManager::setTexture(TextureEntry& entry, Texture2D texture) {
+  // Accounted at the size actually uploaded, not the display size
+  entry.bytes = GetPixelDataSize(texture.width, texture.height, texture.format);
+  if (entry.display_width > 0 && entry.display_height > 0) {
+    texture.width = entry.display_width;
+    texture.height = entry.display_height;
+  }
+  entry.texture = texture;
+  entry.loaded = true;
+  stats_.resident_bytes += entry.bytes;
+  stats_.peak_resident_bytes =
+      std::max(stats_.peak_resident_bytes, stats_.resident_bytes);
+  ++stats_.resident_textures;
+}
+
+void AssetManager::unloadEntry(TextureEntry& entry) {
+  if (!headless_) {
+    UnloadTexture(entry.texture);
+  }
+  // Keep the size around, only the GPU copy goes
+  entry.texture.id = 0;
+  entry.loaded = false;
+  stats_.resident_bytes -= entry.bytes;
+  --stats_.resident_textures;
+  entry.bytes = 0;
+}
+
+void AssetManager::decodeWorker() {
+  PROFILE_THREAD_NAME("asset decode");
+  // Workers share one cursor into the request list, only decoding here.
+  // Decoding (LoadImage or inflating bundled pixels) is pure CPU work so is
+  // safe off the main thread.
+  while (true) {
+    const size_t index = next_request_.fetch_add(1);
+    if (index >= requests_.size()) return;
+    bool owned;
+    Image image = decodeImage(requests_[index].filename,
+                              requests_[index].bundled, owned);
+    {
+      std::lock_guard<std::mutex> lock{decoded_mutex_};
+      decoded_.push_back(DecodedImage{index, image, owned});
+    }
+    decoded_ready_.notify_one();
+  }
+}
+
+void AssetManager::uploadDecoded(const DecodedImage& decoded) {
+  PROFILE_SCOPE("AssetManager::uploadDecoded");
+  const TextureRequest& request = requests_[decoded.request_index];
+  ++num_uploaded_;
+  if (decoded.image.data == nullptr) {
+    LOG_WARNING("Failed to decode " << request.filename);
+  }
+  TextureEntry& entry = textures_[request.handle];
+  entry.queued = false;
+  // Something already loaded it synchronously
+  if (!entry.loaded) {
+    setTexture(entry, textureFromImage(decoded.image));
+  }
+  if (decoded.owned) {
+    UnloadImage(decoded.image);
+  }
+}
+
+void AssetManager::joinWorkers() {
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+Texture2D AssetManager::textureFromImage(const Image& image) const {
+  if (!headless_) {
+    return LoadTextureFromImage(image);
+  }
+  // No GPU context so only keep the dimensions around
+  return Texture2D{0, image.width, image.height, image.mipmaps, image.format};
 }
 
 AssetManager::~AssetManager() {
-  for (auto& pair : textures_) {
-    UnloadTexture(pair.second);
+  // Let any workers finish so they don't outlive the requests they read.
+  // Images they decoded but nobody uploaded are just freed.
+  joinWorkers();
+  for (const auto& decoded : decoded_) {
+    if (decoded.owned) {
+      UnloadImage(decoded.image);
+    }
+  }
+  if (headless_) return;
+  for (auto& entry : textures_) {
+    if (entry.loaded) {
+      UnloadTexture(entry.texture);
+    }
   }
 }
 
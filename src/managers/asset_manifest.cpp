@@ -0,0 +1,197 @@
+#include "managers/asset_manifest.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <unordered_map>
+
+#include "constants.h"
+#include "debug.h"
+#include "nlohmann/json.hpp"
+
+namespace platformer2d {
+
+// Forward declare free helpers
+bool readPngSize(const std::string& path, int& width, int& height);
+std::string deriveAssetName(const std::filesystem::path& relative_path);
+bool readAssetEntry(const nlohmann::json& asset, AssetManifestEntry& entry);
+template <typename T>
+void readCount(const nlohmann::json& asset, const char* key, T& value);
+
+bool AssetManifest::loadFromFile(const std::string& path) {
+  std::ifstream file{path};
+  if (!file.is_open()) {
+    DLOG("Failed to open asset manifest: " << path);
+    return false;
+  }
+  const nlohmann::json json = nlohmann::json::parse(file, nullptr, false);
+  if (json.is_discarded() || !json.is_object() || !json.contains("assets") ||
+      !json["assets"].is_array()) {
+    DLOG("Malformed asset manifest: " << path);
+    return false;
+  }
+  entries_.clear();
+  for (const auto& asset : json["assets"]) {
+    AssetManifestEntry entry;
+    if (!readAssetEntry(asset, entry)) {
+      DLOG("Skipping malformed asset manifest entry " << asset.dump());
+      continue;
+    }
+    entries_.push_back(entry);
+  }
+  return true;
+}
+
+bool AssetManifest::saveToFile(const std::string& path) const {
+  nlohmann::json json;
+  json["assets"] = nlohmann::json::array();
+  for (const auto& entry : entries_) {
+    nlohmann::json asset;
+    asset["name"] = entry.name;
+    asset["path"] = entry.path;
+    asset["bytes"] = entry.bytes;
+    asset["width"] = entry.width;
+    asset["height"] = entry.height;
+    if (entry.display_width > 0 && entry.display_height > 0) {
+      asset["display_width"] = entry.display_width;
+      asset["display_height"] = entry.display_height;
+    }
+    json["assets"].push_back(asset);
+  }
+  std::ofstream file{path};
+  if (!file.is_open()) {
+    DLOG("Failed to open " << path << " for writing");
+    return false;
+  }
+  file << json.dump(2) << '\n';
+  return true;
+}
+
+AssetManifest AssetManifest::scan(const std::string& root,
+                                  const AssetManifest* previous) {
+  std::unordered_map<std::string, const AssetManifestEntry*> previous_by_path;
+  if (previous) {
+    for (const auto& entry : previous->entries_) {
+      previous_by_path.emplace(entry.path, &entry);
+    }
+  }
+
+  AssetManifest manifest;
+  for (const auto& file :
+       std::filesystem::recursive_directory_iterator{root}) {
+    if (!file.is_regular_file() || file.path().extension() != ".png") {
+      continue;
+    }
+    const std::filesystem::path relative =
+        std::filesystem::relative(file.path(), root);
+
+    AssetManifestEntry entry;
+    entry.path = (std::filesystem::path{root} / relative).generic_string();
+    entry.bytes = file.file_size();
+    if (!readPngSize(entry.path, entry.width, entry.height)) {
+      DLOG("Skipping unreadable png " << entry.path);
+      continue;
+    }
+    auto it = previous_by_path.find(entry.path);
+    if (it != previous_by_path.end()) {
+      entry.name = it->second->name;
+      entry.display_width = it->second->display_width;
+      entry.display_height = it->second->display_height;
+    } else {
+      entry.name = deriveAssetName(relative);
+      if (entry.name.starts_with("tile_")) {
+        entry.display_width = kTileSize;
+        entry.display_height = kTileSize;
+      }
+    }
+    manifest.entries_.push_back(entry);
+  }
+
+  std::sort(manifest.entries_.begin(), manifest.entries_.end(),
+            [](const AssetManifestEntry& a, const AssetManifestEntry& b) {
+              return a.path < b.path;
+            });
+  return manifest;
+}
+
+// Free helper functions
+
+// The manifest is edited by hand so nothing about an entry can be assumed.
+// Returns false without a string name and path, sizes that are not valid
+// are left at 0.
+bool readAssetEntry(const nlohmann::json& asset, AssetManifestEntry& entry) {
+  if (!asset.is_object()) return false;
+  const auto name = asset.find("name");
+  const auto path = asset.find("path");
+  if (name == asset.end() || !name->is_string() || path == asset.end() ||
+      !path->is_string()) {
+    return false;
+  }
+  entry.name = name->get<std::string>();
+  entry.path = path->get<std::string>();
+  readCount(asset, "bytes", entry.bytes);
+  readCount(asset, "width", entry.width);
+  readCount(asset, "height", entry.height);
+  readCount(asset, "display_width", entry.display_width);
+  readCount(asset, "display_height", entry.display_height);
+  return true;
+}
+
+// A missing key leaves value as it is, so does a bad one
+template <typename T>
+void readCount(const nlohmann::json& asset, const char* key, T& value) {
+  const auto it = asset.find(key);
+  if (it == asset.end()) return;
+  if (!it->is_number_unsigned() ||
+      it->get<uint64_t>() > (uint64_t)std::numeric_limits<T>::max()) {
+    DLOG("Ignoring " << key << " of asset " << asset["name"].get<std::string>()
+                     << ", not a size: " << it->dump());
+    return;
+  }
+  value = static_cast<T>(it->get<uint64_t>());
+}
+
+// The size is in the IHDR chunk which always directly follows the signature
+bool readPngSize(const std::string& path, int& width, int& height) {
+  constexpr std::array<unsigned char, 8> kPngSignature{
+      0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  std::ifstream file{path, std::ios::binary};
+  std::array<unsigned char, 24> header{};
+  if (!file.read(reinterpret_cast<char*>(header.data()), header.size())) {
+    return false;
+  }
+  if (!std::equal(kPngSignature.begin(), kPngSignature.end(),
+                  header.begin())) {
+    return false;
+  }
+  auto readBigEndian = [&header](size_t offset) {
+    return (int)((uint32_t)header[offset] << 24 |
+                 (uint32_t)header[offset + 1] << 16 |
+                 (uint32_t)header[offset + 2] << 8 |
+                 (uint32_t)header[offset + 3]);
+  };
+  width = readBigEndian(16);
+  height = readBigEndian(20);
+  return true;
+}
+
+std::string deriveAssetName(const std::filesystem::path& relative_path) {
+  std::string name;
+  const bool is_tile = relative_path.has_parent_path();
+  if (is_tile) {
+    name = "tile_";
+    for (const auto& part : relative_path.parent_path()) {
+      name += part.string() + "_";
+    }
+  }
+  name += relative_path.stem().string();
+  std::transform(name.begin(), name.end(), name.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return name;
+}
+
+}  // namespace platformer2d
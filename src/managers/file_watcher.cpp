@@ -0,0 +1,93 @@
+#include "managers/file_watcher.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#include "debug.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace platformer2d {
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher() : fd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+  if (fd_ < 0) {
+    DLOG("Failed to start watching files, hot reload is off");
+  }
+}
+
+FileWatcher::~FileWatcher() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool FileWatcher::watchDirectory(const std::string& directory,
+                                 bool recursive) {
+  if (fd_ < 0) return false;
+  // Editors often save by writing a new file and renaming it over the old
+  // one so moves count as changes too
+  const int watch = inotify_add_watch(fd_, directory.c_str(),
+                                      IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (watch < 0) {
+    DLOG("Failed to watch " << directory);
+    return false;
+  }
+  directories_[watch] = directory;
+  if (!recursive) return true;
+
+  std::error_code error;
+  for (const auto& child :
+       std::filesystem::directory_iterator{directory, error}) {
+    if (child.is_directory()) {
+      watchDirectory(child.path().string(), true);
+    }
+  }
+  return true;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+  std::vector<std::string> changed;
+  if (fd_ < 0) return changed;
+
+  alignas(inotify_event) char buffer[4096];
+  while (true) {
+    const ssize_t length = read(fd_, buffer, sizeof(buffer));
+    // Fails with EAGAIN once everything queued has been read
+    if (length <= 0) break;
+    for (ssize_t offset = 0; offset < length;) {
+      const auto* event =
+          reinterpret_cast<const inotify_event*>(buffer + offset);
+      offset += sizeof(inotify_event) + event->len;
+      auto directory = directories_.find(event->wd);
+      if (event->len == 0 || directory == directories_.end()) continue;
+      std::string path{directory->second + "/" + event->name};
+      if (std::find(changed.begin(), changed.end(), path) == changed.end()) {
+        changed.push_back(std::move(path));
+      }
+    }
+  }
+  return changed;
+}
+
+#else
+
+FileWatcher::FileWatcher() {}
+
+FileWatcher::~FileWatcher() {}
+
+bool FileWatcher::watchDirectory(const std::string& /*directory*/,
+                                 bool /*recursive*/) {
+  DLOG("Hot reload is only supported on Linux");
+  return false;
+}
+
+std::vector<std::string> FileWatcher::poll() { return {}; }
+
+#endif
+
+}  // namespace platformer2d
@@ -4,56 +4,72 @@
 
 namespace platformer2d {
 
-InputManager::InputManager()
-    : is_space_(false),
-      is_left_(false),
-      is_right_(false)
-#ifndef NDEBUG
-      ,
-      is_e_pressed_(false),
-      is_s_pressed_(false),
-      is_mouse_clicked_(false)
-#endif
-{
-}
+InputManager::InputManager() : state_() {}
+
+void InputManager::getInput() { state_ = pollInput(); }
 
-void InputManager::getInput() {
-  is_right_ = IsKeyDown(KEY_RIGHT);
-  is_left_ = IsKeyDown(KEY_LEFT);
-  is_space_ = IsKeyPressed(KEY_SPACE);
+InputState InputManager::pollInput() {
+  InputState state{};
+  state.is_right = IsKeyDown(KEY_RIGHT);
+  state.is_left = IsKeyDown(KEY_LEFT);
+  state.is_space = IsKeyPressed(KEY_SPACE);
 
 // Level Editor stuff DEBUG build only
 #ifndef NDEBUG
-  is_e_pressed_ = IsKeyPressed(KEY_E);
-  is_s_pressed_ = IsKeyPressed(KEY_S);
+  state.is_e_pressed = IsKeyPressed(KEY_E);
+  state.is_s_pressed = IsKeyPressed(KEY_S);
+  state.is_t_pressed = IsKeyPressed(KEY_T);
+  state.is_up = IsKeyDown(KEY_UP);
+  state.is_down = IsKeyDown(KEY_DOWN);
+  state.mouse_wheel = GetMouseWheelMove();
 
   if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
-    is_mouse_clicked_ = true;
-    mouse_position_x_ = GetMouseX();
-    mouse_position_y_ = GetMouseY();
-  } else {
-    is_mouse_clicked_ = false;
+    state.is_mouse_clicked = true;
+    state.mouse_position_x = GetMouseX();
+    state.mouse_position_y = GetMouseY();
   }
 #endif
+
+#ifdef PLATFORMER2D_PROFILE
+  state.is_f3_pressed = IsKeyPressed(KEY_F3);
+  state.is_f4_pressed = IsKeyPressed(KEY_F4);
+#endif
+  return state;
 }
 
-bool InputManager::isRight() const { return is_right_; }
+void InputManager::setInput(const InputState& state) { state_ = state; }
+
+bool InputManager::isRight() const { return state_.is_right; }
 
-bool InputManager::isLeft() const { return is_left_; }
+bool InputManager::isLeft() const { return state_.is_left; }
 
-bool InputManager::isSpace() const { return is_space_; }
+bool InputManager::isSpace() const { return state_.is_space; }
 
 // Level Editor stuff DEBUG build only
 #ifndef NDEBUG
-bool InputManager::isEPressed() const { return is_e_pressed_; }
+bool InputManager::isEPressed() const { return state_.is_e_pressed; }
 
-bool InputManager::isSPressed() const { return is_s_pressed_; }
+bool InputManager::isSPressed() const { return state_.is_s_pressed; }
 
-bool InputManager::mouseClicked() const { return is_mouse_clicked_; }
+bool InputManager::isTPressed() const { return state_.is_t_pressed; }
+
+bool InputManager::isUp() const { return state_.is_up; }
+
+bool InputManager::isDown() const { return state_.is_down; }
+
+float InputManager::getMouseWheel() const { return state_.mouse_wheel; }
+
+bool InputManager::mouseClicked() const { return state_.is_mouse_clicked; }
+
+int InputManager::getMousePositionX() const { return state_.mouse_position_x; }
+
+int InputManager::getMousePositionY() const { return state_.mouse_position_y; }
+#endif
 
-int InputManager::getMousePositionX() const { return mouse_position_x_; }
+#ifdef PLATFORMER2D_PROFILE
+bool InputManager::isF3Pressed() const { return state_.is_f3_pressed; }
 
-int InputManager::getMousePositionY() const { return mouse_position_y_; }
+bool InputManager::isF4Pressed() const { return state_.is_f4_pressed; }
 #endif
 
 }  // namespace platformer2d
@@ -0,0 +1,195 @@
+#include "managers/input_recording.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+#include "atomic_file.h"
+#include "debug.h"
+
+namespace platformer2d {
+
+constexpr char kInputRecordingMagic[4]{'P', '2', 'D', 'I'};
+constexpr uint32_t kInputRecordingVersion{1};
+
+struct InputRecordingHeader {
+  char magic[4];
+  uint32_t version;
+  float timestep;
+  uint32_t num_runs;
+};
+static_assert(sizeof(InputRecordingHeader) == 16);
+
+// One run of ticks with the same input. Mouse position only matters on
+// ticks with a click but is kept as is so replay matches exactly.
+struct InputRunRecord {
+  uint32_t ticks;
+  uint16_t keys;  // InputKeyBit flags
+  uint16_t padding;
+  float mouse_wheel;
+  int32_t mouse_position_x;
+  int32_t mouse_position_y;
+};
+static_assert(sizeof(InputRunRecord) == 20);
+
+enum InputKeyBit : uint16_t {
+  kInputKeyRight = 1 << 0,
+  kInputKeyLeft = 1 << 1,
+  kInputKeySpace = 1 << 2,
+  kInputKeyE = 1 << 3,
+  kInputKeyS = 1 << 4,
+  kInputKeyT = 1 << 5,
+  kInputKeyUp = 1 << 6,
+  kInputKeyDown = 1 << 7,
+  kInputKeyMouseClick = 1 << 8,
+  kInputKeyF3 = 1 << 9,
+  kInputKeyF4 = 1 << 10,
+};
+
+// Forward declare free helpers
+InputRunRecord packInputRun(const InputState& state, uint32_t ticks);
+InputState unpackInputRun(const InputRunRecord& record);
+
+void InputRecording::reset(float timestep) {
+  runs_.clear();
+  num_ticks_ = 0;
+  timestep_ = timestep;
+}
+
+void InputRecording::record(const InputState& state) {
+  if (runs_.empty() || !(runs_.back().state == state)) {
+    runs_.push_back(Run{num_ticks_, state});
+  }
+  ++num_ticks_;
+}
+
+InputState InputRecording::getInput(uint64_t tick) const {
+  if (tick >= num_ticks_) {
+    return InputState{};
+  }
+  // Find the last run starting at or before this tick
+  auto it = std::upper_bound(
+      runs_.begin(), runs_.end(), tick,
+      [](uint64_t value, const Run& run) { return value < run.first_tick; });
+  return std::prev(it)->state;
+}
+
+bool InputRecording::loadFromFile(const std::string& path) {
+  std::ifstream file{path, std::ios::binary};
+  if (!file.is_open()) {
+    LOG_WARNING("Failed to open input recording " << path);
+    return false;
+  }
+  InputRecordingHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, kInputRecordingMagic,
+                  sizeof(kInputRecordingMagic)) != 0 ||
+      header.version != kInputRecordingVersion || !(header.timestep > 0)) {
+    LOG_WARNING(path << " is not a version " << kInputRecordingVersion
+                     << " input recording");
+    return false;
+  }
+  // Checked before sizing anything from the header
+  const std::streampos runs_start = file.tellg();
+  file.seekg(0, std::ios::end);
+  const uint64_t runs_size = file.tellg() - runs_start;
+  file.seekg(runs_start);
+  if ((uint64_t)header.num_runs * sizeof(InputRunRecord) > runs_size) {
+    LOG_WARNING("Input recording " << path << " is truncated");
+    return false;
+  }
+  std::vector<InputRunRecord> records(header.num_runs);
+  if (!file.read(reinterpret_cast<char*>(records.data()),
+                 records.size() * sizeof(InputRunRecord))) {
+    LOG_WARNING("Input recording " << path << " is truncated");
+    return false;
+  }
+
+  reset(header.timestep);
+  runs_.reserve(records.size());
+  for (const auto& record : records) {
+    if (record.ticks == 0) {
+      LOG_WARNING("Input recording " << path << " has an empty run");
+      reset(kFixedTimestep);
+      return false;
+    }
+    runs_.push_back(Run{num_ticks_, unpackInputRun(record)});
+    num_ticks_ += record.ticks;
+  }
+  return true;
+}
+
+bool InputRecording::saveToFile(const std::string& path) const {
+  std::vector<InputRunRecord> records;
+  records.reserve(runs_.size());
+  for (size_t i = 0; i < runs_.size(); ++i) {
+    const uint64_t end =
+        i + 1 < runs_.size() ? runs_[i + 1].first_tick : num_ticks_;
+    // Runs longer than a record can count are split, it never happens in
+    // practice (over two years of ticks)
+    for (uint64_t ticks = end - runs_[i].first_tick; ticks > 0;) {
+      const uint32_t record_ticks = std::min<uint64_t>(
+          ticks, std::numeric_limits<uint32_t>::max());
+      records.push_back(packInputRun(runs_[i].state, record_ticks));
+      ticks -= record_ticks;
+    }
+  }
+
+  InputRecordingHeader header;
+  std::memcpy(header.magic, kInputRecordingMagic,
+              sizeof(kInputRecordingMagic));
+  header.version = kInputRecordingVersion;
+  header.timestep = timestep_;
+  header.num_runs = records.size();
+
+  std::string contents(sizeof(header) + records.size() * sizeof(InputRunRecord),
+                       '\0');
+  std::memcpy(contents.data(), &header, sizeof(header));
+  std::memcpy(contents.data() + sizeof(header), records.data(),
+              records.size() * sizeof(InputRunRecord));
+  return writeFileAtomic(path, contents);
+}
+
+// Free helper Methods
+InputRunRecord packInputRun(const InputState& state, uint32_t ticks) {
+  InputRunRecord record{};
+  record.ticks = ticks;
+  record.keys = (state.is_right ? kInputKeyRight : 0) |
+                (state.is_left ? kInputKeyLeft : 0) |
+                (state.is_space ? kInputKeySpace : 0) |
+                (state.is_e_pressed ? kInputKeyE : 0) |
+                (state.is_s_pressed ? kInputKeyS : 0) |
+                (state.is_t_pressed ? kInputKeyT : 0) |
+                (state.is_up ? kInputKeyUp : 0) |
+                (state.is_down ? kInputKeyDown : 0) |
+                (state.is_mouse_clicked ? kInputKeyMouseClick : 0) |
+                (state.is_f3_pressed ? kInputKeyF3 : 0) |
+                (state.is_f4_pressed ? kInputKeyF4 : 0);
+  record.mouse_wheel = state.mouse_wheel;
+  record.mouse_position_x = state.mouse_position_x;
+  record.mouse_position_y = state.mouse_position_y;
+  return record;
+}
+
+InputState unpackInputRun(const InputRunRecord& record) {
+  InputState state{};
+  state.is_right = record.keys & kInputKeyRight;
+  state.is_left = record.keys & kInputKeyLeft;
+  state.is_space = record.keys & kInputKeySpace;
+  state.is_e_pressed = record.keys & kInputKeyE;
+  state.is_s_pressed = record.keys & kInputKeyS;
+  state.is_t_pressed = record.keys & kInputKeyT;
+  state.is_up = record.keys & kInputKeyUp;
+  state.is_down = record.keys & kInputKeyDown;
+  state.is_mouse_clicked = record.keys & kInputKeyMouseClick;
+  state.is_f3_pressed = record.keys & kInputKeyF3;
+  state.is_f4_pressed = record.keys & kInputKeyF4;
+  state.mouse_wheel = record.mouse_wheel;
+  state.mouse_position_x = record.mouse_position_x;
+  state.mouse_position_y = record.mouse_position_y;
+  return state;
+}
+
+}  // namespace platformer2d
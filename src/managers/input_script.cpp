@@ -0,0 +1,116 @@
+#include "managers/input_script.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "debug.h"
+
+namespace platformer2d {
+
+bool InputScript::loadFromFile(const std::string& path) {
+  std::ifstream file{path};
+  if (!file.is_open()) {
+    DLOG("Failed to open input script: " << path);
+    return false;
+  }
+  entries_.clear();
+  std::string line;
+  int line_number{0};
+  while (std::getline(file, line)) {
+    ++line_number;
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream line_stream{line};
+    Entry entry{};
+    std::string keys;
+    if (!(line_stream >> entry.tick >> keys)) {
+      DLOG("Malformed input script line " << line_number << ": " << line);
+      return false;
+    }
+    for (char key : keys) {
+      switch (key) {
+        case 'R':
+          entry.state.is_right = true;
+          break;
+        case 'L':
+          entry.state.is_left = true;
+          break;
+        case 'J':
+          entry.state.is_space = true;
+          break;
+        case 'U':
+          entry.state.is_up = true;
+          break;
+        case 'D':
+          entry.state.is_down = true;
+          break;
+        case 'I':
+          entry.state.mouse_wheel += 1;
+          break;
+        case 'O':
+          entry.state.mouse_wheel -= 1;
+          break;
+        case 'E':
+          entry.state.is_e_pressed = true;
+          break;
+        case 'S':
+          entry.state.is_s_pressed = true;
+          break;
+        case 'T':
+          entry.state.is_t_pressed = true;
+          break;
+        case 'M':
+          entry.state.is_mouse_clicked = true;
+          break;
+        case '-':
+          break;
+        default:
+          DLOG("Unknown key '" << key << "' in input script line "
+                               << line_number);
+          return false;
+      }
+    }
+    if (entry.state.is_mouse_clicked &&
+        !(line_stream >> entry.state.mouse_position_x >>
+          entry.state.mouse_position_y)) {
+      DLOG("Click without a position in input script line " << line_number);
+      return false;
+    }
+    entries_.push_back(entry);
+  }
+  std::stable_sort(
+      entries_.begin(), entries_.end(),
+      [](const Entry& a, const Entry& b) { return a.tick < b.tick; });
+  return true;
+}
+
+InputState InputScript::getInput(uint64_t tick) const {
+  // Find the last entry at or before this tick
+  auto it = std::upper_bound(
+      entries_.begin(), entries_.end(), tick,
+      [](uint64_t value, const Entry& entry) { return value < entry.tick; });
+  if (it == entries_.begin()) {
+    return InputState{};
+  }
+  --it;
+  InputState state{};
+  state.is_right = it->state.is_right;
+  state.is_left = it->state.is_left;
+  state.is_up = it->state.is_up;
+  state.is_down = it->state.is_down;
+  // Presses only happen on the tick they were scripted for
+  if (it->tick == tick) {
+    state.is_space = it->state.is_space;
+    state.is_e_pressed = it->state.is_e_pressed;
+    state.is_s_pressed = it->state.is_s_pressed;
+    state.is_t_pressed = it->state.is_t_pressed;
+    state.is_mouse_clicked = it->state.is_mouse_clicked;
+    state.mouse_position_x = it->state.mouse_position_x;
+    state.mouse_position_y = it->state.mouse_position_y;
+    state.mouse_wheel = it->state.mouse_wheel;
+  }
+  return state;
+}
+
+}  // namespace platformer2d
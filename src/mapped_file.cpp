@@ -0,0 +1,49 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "debug.h"
+
+namespace platformer2d {
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string& path, bool sequential) {
+  close();
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+  void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    DLOG("Failed to map " << path);
+    return false;
+  }
+  data_ = static_cast<const uint8_t*>(mapping);
+  size_ = info.st_size;
+  if (sequential) {
+    madvise(mapping, size_, MADV_SEQUENTIAL);
+    madvise(mapping, size_, MADV_WILLNEED);
+  }
+  return true;
+}
+
+void MappedFile::close() {
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+}  // namespace platformer2d
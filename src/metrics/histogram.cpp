@@ -0,0 +1,40 @@
+#include "metrics/histogram.h"
+
+#include <cmath>
+
+namespace platformer2d {
+
+void Histogram::reset() {
+  counts_.fill(0);
+  count_ = 0;
+  sum_ = 0;
+  min_ = std::numeric_limits<uint64_t>::max();
+  max_ = 0;
+}
+
+uint64_t Histogram::getPercentile(double fraction) const {
+  if (count_ == 0) return 0;
+  const uint64_t target = std::clamp<uint64_t>(
+      (uint64_t)std::ceil(fraction * count_), 1, count_);
+  uint64_t seen{0};
+  for (size_t bucket = 0; bucket < counts_.size(); ++bucket) {
+    seen += counts_[bucket];
+    if (seen >= target) {
+      return std::min(getBucketHighest(bucket), max_);
+    }
+  }
+  return max_;
+}
+
+uint64_t Histogram::getBucketHighest(size_t bucket) {
+  if (bucket < kHistogramSubBuckets) {
+    return bucket;
+  }
+  const size_t above = bucket - kHistogramSubBuckets;
+  const uint32_t shift = above / (kHistogramSubBuckets / 2) + 1;
+  const uint64_t sub_bucket =
+      above % (kHistogramSubBuckets / 2) + kHistogramSubBuckets / 2;
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+}  // namespace platformer2d
@@ -0,0 +1,84 @@
+#include "metrics/metrics_registry.h"
+
+#include "debug.h"
+
+namespace platformer2d {
+
+// Forward declare free helpers
+void writeMetricSnapshot(std::ostream& output, uint64_t window,
+                         const MetricSnapshot& snapshot);
+
+MetricsRegistry::~MetricsRegistry() {
+  if (dump_.is_open() && frame_ % kMetricsWindowFrames != 0) {
+    finishWindow();
+  }
+}
+
+Counter& MetricsRegistry::addCounter(const std::string& name) {
+  counters_.push_back({name, std::make_unique<Counter>()});
+  return *counters_.back().metric;
+}
+
+Gauge& MetricsRegistry::addGauge(const std::string& name) {
+  gauges_.push_back({name, std::make_unique<Gauge>()});
+  return *gauges_.back().metric;
+}
+
+Histogram& MetricsRegistry::addHistogram(const std::string& name) {
+  histograms_.push_back({name, std::make_unique<Histogram>()});
+  return *histograms_.back().metric;
+}
+
+bool MetricsRegistry::openDump(const std::string& path) {
+  dump_.close();
+  dump_.open(path, std::ios::trunc);
+  if (!dump_.is_open()) {
+    DLOG("Could not open metrics file " << path);
+    return false;
+  }
+  dump_ << "window,metric,type,value,count,p50,p95,p99,max\n";
+  return true;
+}
+
+void MetricsRegistry::endFrame() {
+  if (++frame_ % kMetricsWindowFrames == 0) {
+    finishWindow();
+  }
+}
+
+void MetricsRegistry::finishWindow() {
+  last_window_.clear();
+  for (const auto& [name, counter] : counters_) {
+    last_window_.push_back(
+        MetricSnapshot{name, "counter", (double)counter->getValue()});
+  }
+  for (const auto& [name, gauge] : gauges_) {
+    last_window_.push_back(MetricSnapshot{name, "gauge", gauge->getValue()});
+  }
+  for (const auto& [name, histogram] : histograms_) {
+    last_window_.push_back(MetricSnapshot{
+        name, "histogram", histogram->getMean(), histogram->getCount(),
+        histogram->getPercentile(0.5), histogram->getPercentile(0.95),
+        histogram->getPercentile(0.99), histogram->getMax()});
+    histogram->reset();
+  }
+  if (dump_.is_open()) {
+    for (const auto& snapshot : last_window_) {
+      writeMetricSnapshot(dump_, window_, snapshot);
+    }
+    // Once per window so a crash loses at most the window in progress
+    dump_.flush();
+  }
+  ++window_;
+}
+
+// Free helper Methods
+void writeMetricSnapshot(std::ostream& output, uint64_t window,
+                         const MetricSnapshot& snapshot) {
+  output << window << ',' << snapshot.name << ',' << snapshot.type << ','
+         << snapshot.value << ',' << snapshot.count << ',' << snapshot.p50
+         << ',' << snapshot.p95 << ',' << snapshot.p99 << ',' << snapshot.max
+         << '\n';
+}
+
+}  // namespace platformer2d
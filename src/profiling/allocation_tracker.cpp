@@ -0,0 +1,236 @@
+#include "profiling/allocation_tracker.h"
+
+#ifdef PLATFORMER2D_TRACK_ALLOCATIONS
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "profiling/profiler.h"
+
+namespace platformer2d {
+
+// Zone charged for allocations made outside every PROFILE_SCOPE
+constexpr char kNoAllocationZone[]{"(no zone)"};
+constexpr char kOtherAllocationZones[]{"(other zones)"};
+
+// Forward declare free helpers
+void addAllocationSite(std::vector<AllocationSite>& sites,
+                       std::string_view zone, uint64_t count, uint64_t bytes);
+void sortAllocationSites(std::vector<AllocationSite>& sites);
+
+thread_local AllocationTracker::ThreadSlot* AllocationTracker::thread_slot_{
+    nullptr};
+thread_local bool AllocationTracker::is_internal_{false};
+
+struct AllocationTracker::SlotOwner {
+  ThreadSlot* slot{nullptr};
+  ~SlotOwner() {
+    if (slot != nullptr) {
+      slot->in_use.store(false, std::memory_order_release);
+    }
+  }
+};
+
+AllocationTracker& AllocationTracker::get() {
+  // Never destroyed, operator delete still runs during static destruction
+  alignas(AllocationTracker) static unsigned char
+      storage[sizeof(AllocationTracker)];
+  static AllocationTracker* tracker = new (storage) AllocationTracker;
+  return *tracker;
+}
+
+void AllocationTracker::recordAllocation(size_t bytes) {
+  if (is_internal_) return;
+  const char* zone = Profiler::getCurrentZone();
+  ZoneCounter& counter = getZoneCounter(
+      getThreadSlot(), zone != nullptr ? zone : kNoAllocationZone);
+  counter.count.fetch_add(1, std::memory_order_relaxed);
+  counter.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void AllocationTracker::recordFree() {
+  if (is_internal_) return;
+  getThreadSlot().frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocationTracker::endFrame() {
+  is_internal_ = true;
+  last_frame_.count = 0;
+  last_frame_.bytes = 0;
+  last_frame_.frees = 0;
+  last_frame_.sites.clear();
+  for (size_t i = 0; i <= slots_.size(); ++i) {
+    ThreadSlot& slot = i < slots_.size() ? slots_[i] : overflow_slot_;
+    const uint64_t frees = slot.frees.load(std::memory_order_relaxed);
+    last_frame_.frees += frees - seen_frees_[i];
+    seen_frees_[i] = frees;
+    for (size_t z = 0; z < slot.zones.size(); ++z) {
+      const ZoneCounter& counter = slot.zones[z];
+      const char* zone = counter.zone.load(std::memory_order_acquire);
+      if (zone == nullptr) continue;
+      const uint64_t count = counter.count.load(std::memory_order_relaxed);
+      const uint64_t bytes = counter.bytes.load(std::memory_order_relaxed);
+      if (count == seen_counts_[i][z]) continue;
+      addAllocationSite(last_frame_.sites, zone, count - seen_counts_[i][z],
+                        bytes - seen_bytes_[i][z]);
+      seen_counts_[i][z] = count;
+      seen_bytes_[i][z] = bytes;
+    }
+  }
+  for (const auto& site : last_frame_.sites) {
+    last_frame_.count += site.count;
+    last_frame_.bytes += site.bytes;
+    addAllocationSite(totals_, site.zone, site.count, site.bytes);
+  }
+  sortAllocationSites(last_frame_.sites);
+  sortAllocationSites(totals_);
+  frame_counts_.push_back(last_frame_.count);
+  is_internal_ = false;
+}
+
+AllocationTracker::ThreadSlot& AllocationTracker::getThreadSlot() {
+  if (thread_slot_ != nullptr) {
+    return *thread_slot_;
+  }
+  is_internal_ = true;
+  thread_slot_ = &overflow_slot_;
+  for (auto& slot : slots_) {
+    bool expected{false};
+    if (slot.in_use.compare_exchange_strong(expected, true,
+                                            std::memory_order_acquire)) {
+      thread_slot_ = &slot;
+      // Its destructor runs when the thread exits
+      thread_local SlotOwner owner;
+      owner.slot = &slot;
+      break;
+    }
+  }
+  is_internal_ = false;
+  return *thread_slot_;
+}
+
+AllocationTracker::ZoneCounter& AllocationTracker::getZoneCounter(
+    ThreadSlot& slot, const char* zone) {
+  // Open addressing on the name's address. The overflow slot is shared so
+  // zones are claimed with a compare and swap.
+  const size_t num_probed = slot.zones.size() - 1;
+  const size_t start = (reinterpret_cast<uintptr_t>(zone) >> 3) % num_probed;
+  for (size_t i = 0; i < num_probed; ++i) {
+    ZoneCounter& counter = slot.zones[(start + i) % num_probed];
+    const char* current = counter.zone.load(std::memory_order_acquire);
+    if (current == nullptr &&
+        counter.zone.compare_exchange_strong(current, zone,
+                                             std::memory_order_acq_rel)) {
+      return counter;
+    }
+    if (current == zone) {
+      return counter;
+    }
+  }
+  ZoneCounter& other = slot.zones.back();
+  other.zone.store(kOtherAllocationZones, std::memory_order_release);
+  return other;
+}
+
+// Free helper Methods
+
+// Zones are merged by name, the same literal can have a different address
+// in each file
+void addAllocationSite(std::vector<AllocationSite>& sites,
+                       std::string_view zone, uint64_t count, uint64_t bytes) {
+  auto it = std::find_if(sites.begin(), sites.end(),
+                         [zone](const AllocationSite& site) {
+                           return site.zone == zone;
+                         });
+  if (it == sites.end()) {
+    sites.push_back(AllocationSite{zone, count, bytes});
+    return;
+  }
+  it->count += count;
+  it->bytes += bytes;
+}
+
+void sortAllocationSites(std::vector<AllocationSite>& sites) {
+  std::sort(sites.begin(), sites.end(),
+            [](const AllocationSite& a, const AllocationSite& b) {
+              return a.count > b.count;
+            });
+}
+
+}  // namespace platformer2d
+
+// Replacements for every global operator new and delete. Only plain malloc
+// and free underneath so nothing here allocates through them again.
+
+void* operator new(std::size_t size) {
+  platformer2d::AllocationTracker::get().recordAllocation(size);
+  void* pointer = std::malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc{};
+  }
+  return pointer;
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  platformer2d::AllocationTracker::get().recordAllocation(size);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+  return operator new(size, tag);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  platformer2d::AllocationTracker::get().recordAllocation(size);
+  // aligned_alloc wants a multiple of the alignment
+  const size_t align = static_cast<size_t>(alignment);
+  void* pointer =
+      std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) &
+                                    ~(align - 1));
+  if (pointer == nullptr) {
+    throw std::bad_alloc{};
+  }
+  return pointer;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept {
+  if (pointer == nullptr) return;
+  platformer2d::AllocationTracker::get().recordFree();
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept { operator delete(pointer); }
+
+void operator delete(void* pointer, std::size_t) noexcept {
+  operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept {
+  operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+  operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+  operator delete(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept {
+  operator delete(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept {
+  operator delete(pointer);
+}
+
+#endif
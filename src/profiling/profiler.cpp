@@ -0,0 +1,281 @@
+#include "profiling/profiler.h"
+
+#ifdef PLATFORMER2D_PROFILE
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+
+#include "atomic_file.h"
+#include "constants.h"
+#include "debug.h"
+#include "nlohmann/json.hpp"
+#include "profiling/allocation_tracker.h"
+
+namespace platformer2d {
+
+constexpr float kOverlayWidth{300.0f};
+constexpr float kOverlayGraphHeight{60.0f};
+// The graph's full height, two frames at the target frame rate
+constexpr double kOverlayGraphMs{2000.0 / kTargetFPS};
+constexpr size_t kOverlayZones{8};
+constexpr int kOverlayFontSize{10};
+constexpr int kOverlayLineHeight{12};
+// Frame summary, allocations and the zones
+#ifdef PLATFORMER2D_TRACK_ALLOCATIONS
+constexpr size_t kOverlayLines{kOverlayZones + 2};
+#else
+constexpr size_t kOverlayLines{kOverlayZones + 1};
+#endif
+
+// Forward declare free helpers
+double getProfileMs(uint64_t ns);
+std::string formatProfileMs(double ms);
+
+thread_local Profiler::ThreadBuffer* Profiler::thread_buffer_{nullptr};
+
+struct Profiler::ThreadSlot {
+  ThreadBuffer* buffer{nullptr};
+  ~ThreadSlot() {
+    if (buffer != nullptr) {
+      Profiler::get().releaseThread(*buffer);
+    }
+  }
+};
+
+Profiler& Profiler::get() {
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler()
+    : epoch_ns_(now()),
+      frame_start_ns_(epoch_ns_),
+      history_(kProfileHistoryFrames) {}
+
+uint64_t Profiler::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void Profiler::setThreadName(const std::string& name) {
+  const ThreadBuffer& buffer = getThreadBuffer();
+  std::lock_guard<std::mutex> lock{mutex_};
+  thread_names_[buffer.thread_id] = name;
+}
+
+void Profiler::record(const char* name, uint64_t start_ns, uint64_t end_ns) {
+  ThreadBuffer& buffer = getThreadBuffer();
+  if (!buffer.zones.tryPush(
+          ProfileZone{name, start_ns, end_ns, buffer.thread_id})) {
+    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void Profiler::endFrame() {
+  ProfileFrame& frame = history_[next_frame_];
+  frame.start_ns = frame_start_ns_;
+  frame.end_ns = now();
+  frame.zones.clear();
+  frame.dropped = 0;
+  drain(frame);
+  frame_start_ns_ = frame.end_ns;
+  next_frame_ = (next_frame_ + 1) % history_.size();
+  num_frames_ = std::min(num_frames_ + 1, history_.size());
+}
+
+void Profiler::startCapture() {
+  captured_.clear();
+  capturing_ = true;
+  DLOG("Profiler capture started");
+}
+
+bool Profiler::stopCapture(const std::string& path) {
+  // Pick up what was recorded since the last frame ended
+  endFrame();
+  capturing_ = false;
+
+  nlohmann::json events = nlohmann::json::array();
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (size_t id = 0; id < thread_names_.size(); ++id) {
+      events.push_back({{"name", "thread_name"},
+                        {"ph", "M"},
+                        {"pid", 1},
+                        {"tid", id},
+                        {"args", {{"name", thread_names_[id]}}}});
+    }
+  }
+  // Chrome wants microseconds
+  for (const auto& zone : captured_) {
+    events.push_back({{"name", zone.name},
+                      {"ph", "X"},
+                      {"pid", 1},
+                      {"tid", zone.thread_id},
+                      {"ts", (zone.start_ns - epoch_ns_) / 1000.0},
+                      {"dur", (zone.end_ns - zone.start_ns) / 1000.0}});
+  }
+  nlohmann::json trace;
+  trace["traceEvents"] = std::move(events);
+  trace["displayTimeUnit"] = "ms";
+  DLOG("Writing " << captured_.size() << " profile zones to " << path);
+  captured_.clear();
+  captured_.shrink_to_fit();
+  return writeFileAtomic(path, trace.dump());
+}
+
+void Profiler::drawOverlay(RenderCommandList& commands) const {
+  const float x = kScreenWidth - kOverlayWidth - 10;
+  const float y = 10;
+  commands.drawRectangle(
+      Rectangle{x, y, kOverlayWidth,
+                kOverlayGraphHeight + kOverlayLines * kOverlayLineHeight + 8},
+      Fade(BLACK, 0.7f));
+
+  // One bar per frame, oldest on the left
+  struct ZoneTotal {
+    uint64_t ns{0};
+    size_t calls{0};
+  };
+  std::unordered_map<std::string_view, ZoneTotal> totals;
+  const float bar_width = kOverlayWidth / history_.size();
+  const size_t oldest =
+      (next_frame_ + history_.size() - num_frames_) % history_.size();
+  double total_ms{0};
+  double max_ms{0};
+  size_t dropped{0};
+  for (size_t i = 0; i < num_frames_; ++i) {
+    const ProfileFrame& frame = history_[(oldest + i) % history_.size()];
+    const double ms = getProfileMs(frame.end_ns - frame.start_ns);
+    total_ms += ms;
+    max_ms = std::max(max_ms, ms);
+    dropped += frame.dropped;
+    const float height =
+        std::min(ms / kOverlayGraphMs, 1.0) * kOverlayGraphHeight;
+    commands.drawRectangle(
+        Rectangle{x + i * bar_width, y + kOverlayGraphHeight - height,
+                  bar_width, height},
+        ms * kTargetFPS > 1000.0 ? RED : GREEN);
+    for (const auto& zone : frame.zones) {
+      ZoneTotal& total = totals[zone.name];
+      total.ns += zone.end_ns - zone.start_ns;
+      ++total.calls;
+    }
+  }
+  // The frame budget sits half way up
+  const float budget_y = y + kOverlayGraphHeight / 2;
+  commands.drawLine(Vector2{x, budget_y}, Vector2{x + kOverlayWidth, budget_y},
+                    1, YELLOW);
+
+  const size_t num_frames = std::max<size_t>(num_frames_, 1);
+  int text_y = y + kOverlayGraphHeight + 4;
+  std::string summary{"frame avg " + formatProfileMs(total_ms / num_frames) +
+                      " max " + formatProfileMs(max_ms)};
+  if (dropped > 0) {
+    summary += " dropped " + std::to_string(dropped);
+  }
+  if (capturing_) {
+    summary += " capturing";
+  }
+  commands.drawText(summary, x + 4, text_y, kOverlayFontSize, WHITE);
+  text_y += kOverlayLineHeight;
+
+#ifdef PLATFORMER2D_TRACK_ALLOCATIONS
+  // Last frame only, a steady state frame should show none
+  const AllocationFrame& allocations = AllocationTracker::get().getLastFrame();
+  std::string allocation_line{
+      "allocs " + std::to_string(allocations.count) + " " +
+      std::to_string(allocations.bytes) + " bytes"};
+  if (!allocations.sites.empty()) {
+    allocation_line += " top " + std::string{allocations.sites[0].zone} +
+                       " x" + std::to_string(allocations.sites[0].count);
+  }
+  commands.drawText(allocation_line, x + 4, text_y, kOverlayFontSize,
+                    allocations.count > 0 ? RED : WHITE);
+  text_y += kOverlayLineHeight;
+#endif
+
+  // Most expensive zones, time and calls per frame
+  std::vector<std::pair<std::string_view, ZoneTotal>> sorted(totals.begin(),
+                                                             totals.end());
+  std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+    return a.second.ns > b.second.ns;
+  });
+  sorted.resize(std::min(sorted.size(), kOverlayZones));
+  for (const auto& [name, total] : sorted) {
+    commands.drawText(
+        std::string{name} + " " +
+            formatProfileMs(getProfileMs(total.ns) / num_frames) + " x" +
+            std::to_string((total.calls + num_frames - 1) / num_frames),
+        x + 4, text_y, kOverlayFontSize, WHITE);
+    text_y += kOverlayLineHeight;
+  }
+}
+
+Profiler::ThreadBuffer& Profiler::getThreadBuffer() {
+  if (thread_buffer_ == nullptr) {
+    thread_buffer_ = &registerThread();
+  }
+  return *thread_buffer_;
+}
+
+Profiler::ThreadBuffer& Profiler::registerThread() {
+  // Only constructed on a thread that records, its destructor runs when the
+  // thread exits
+  thread_local ThreadSlot slot;
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto it = std::find_if(buffers_.begin(), buffers_.end(),
+                         [](const auto& buffer) { return !buffer->in_use; });
+  if (it == buffers_.end()) {
+    buffers_.push_back(std::make_unique<ThreadBuffer>());
+    it = buffers_.end() - 1;
+  }
+  ThreadBuffer& buffer = **it;
+  // A reused buffer may still hold the old thread's zones, they keep their
+  // own id
+  buffer.in_use = true;
+  buffer.thread_id = thread_names_.size();
+  thread_names_.push_back("thread " + std::to_string(buffer.thread_id));
+  slot.buffer = &buffer;
+  return buffer;
+}
+
+void Profiler::releaseThread(ThreadBuffer& buffer) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  buffer.in_use = false;
+}
+
+void Profiler::drain(ProfileFrame& frame) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  ProfileZone zone;
+  for (auto& buffer : buffers_) {
+    while (buffer->zones.tryPop(zone)) {
+      frame.zones.push_back(zone);
+    }
+    frame.dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+  }
+  if (!capturing_) return;
+  const size_t room = kMaxCapturedZones - captured_.size();
+  if (frame.zones.size() > room) {
+    DLOG("Profile capture is full, dropping zones");
+  }
+  captured_.insert(captured_.end(), frame.zones.begin(),
+                   frame.zones.begin() + std::min(room, frame.zones.size()));
+}
+
+// Free helper Methods
+double getProfileMs(uint64_t ns) { return ns / 1e6; }
+
+std::string formatProfileMs(double ms) {
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(2) << ms << " ms";
+  return stream.str();
+}
+
+}  // namespace platformer2d
+
+#endif
@@ -0,0 +1,68 @@
+#include "render/null_render_backend.h"
+
+#include <ostream>
+
+namespace platformer2d {
+
+NullRenderBackend::NullRenderBackend(std::ostream* record_stream)
+    : record_stream_(record_stream), stats_() {}
+
+void NullRenderBackend::submit(const RenderCommandList& commands) {
+  for (const auto& command : commands.getCommands()) {
+    ++stats_.commands_by_type[static_cast<size_t>(command.type)];
+    if (record_stream_) {
+      record(commands, command);
+    }
+  }
+  stats_.commands += commands.size();
+  if (record_stream_) {
+    *record_stream_ << "end_frame " << stats_.frames << '\n';
+  }
+  ++stats_.frames;
+}
+
+void NullRenderBackend::record(const RenderCommandList& commands,
+                               const RenderCommand& command) const {
+  std::ostream& out = *record_stream_;
+  switch (command.type) {
+    case RenderCommandType::kClear:
+      out << "clear";
+      break;
+    case RenderCommandType::kTexture:
+      out << "texture " << command.texture.id << ' ' << command.dest.x << ' '
+          << command.dest.y;
+      break;
+    case RenderCommandType::kTexturePro:
+      out << "texture_pro " << command.texture.id << ' ' << command.source.x
+          << ' ' << command.source.y << ' ' << command.source.width << ' '
+          << command.source.height << ' ' << command.dest.x << ' '
+          << command.dest.y << ' ' << command.dest.width << ' '
+          << command.dest.height;
+      break;
+    case RenderCommandType::kText:
+      out << "text " << command.dest.x << ' ' << command.dest.y << ' '
+          << command.dest.height << " \"" << commands.getText(command) << '"';
+      break;
+    case RenderCommandType::kLine:
+      out << "line " << command.start.x << ' ' << command.start.y << ' '
+          << command.end.x << ' ' << command.end.y << ' '
+          << command.thickness;
+      break;
+    case RenderCommandType::kRectangle:
+      out << "rectangle " << command.dest.x << ' ' << command.dest.y << ' '
+          << command.dest.width << ' ' << command.dest.height;
+      break;
+    case RenderCommandType::kBeginCamera:
+      out << "begin_camera " << command.start.x << ' ' << command.start.y
+          << ' ' << command.end.x << ' ' << command.end.y << ' '
+          << command.thickness;
+      break;
+    case RenderCommandType::kEndCamera:
+      out << "end_camera";
+      break;
+  }
+  out << " rgba " << (int)command.color.r << ' ' << (int)command.color.g << ' '
+      << (int)command.color.b << ' ' << (int)command.color.a << '\n';
+}
+
+}  // namespace platformer2d
@@ -0,0 +1,45 @@
+#include "render/raylib_render_backend.h"
+
+#include "raylib.h"
+
+namespace platformer2d {
+
+void RaylibRenderBackend::submit(const RenderCommandList& commands) {
+  BeginDrawing();
+  for (const auto& command : commands.getCommands()) {
+    switch (command.type) {
+      case RenderCommandType::kClear:
+        ClearBackground(command.color);
+        break;
+      case RenderCommandType::kTexture:
+        DrawTexture(command.texture, command.dest.x, command.dest.y,
+                    command.color);
+        break;
+      case RenderCommandType::kTexturePro:
+        DrawTexturePro(command.texture, command.source, command.dest,
+                       Vector2{0.0f, 0.0f}, 0.0f, command.color);
+        break;
+      case RenderCommandType::kText:
+        DrawText(commands.getText(command), command.dest.x, command.dest.y,
+                 command.dest.height, command.color);
+        break;
+      case RenderCommandType::kLine:
+        DrawLineEx(command.start, command.end, command.thickness,
+                   command.color);
+        break;
+      case RenderCommandType::kRectangle:
+        DrawRectangleRec(command.dest, command.color);
+        break;
+      case RenderCommandType::kBeginCamera:
+        BeginMode2D(Camera2D{command.end, command.start, 0.0f,
+                             command.thickness});
+        break;
+      case RenderCommandType::kEndCamera:
+        EndMode2D();
+        break;
+    }
+  }
+  EndDrawing();
+}
+
+}  // namespace platformer2d
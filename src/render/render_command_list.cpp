@@ -0,0 +1,97 @@
+#include "render/render_command_list.h"
+
+#include <string_view>
+
+#include "debug.h"
+#include "raylib.h"
+
+namespace platformer2d {
+
+void RenderCommandList::clear() {
+  commands_.clear();
+  text_buffer_.clear();
+}
+
+void RenderCommandList::clearBackground(Color color) {
+  RenderCommand command{};
+  command.type = RenderCommandType::kClear;
+  command.color = color;
+  commands_.push_back(command);
+}
+
+void RenderCommandList::drawTexture(const Texture2D& texture, float x, float y,
+                                    Color tint) {
+  RenderCommand command{};
+  command.type = RenderCommandType::kTexture;
+  command.texture = texture;
+  command.dest = Rectangle{x, y, (float)texture.width, (float)texture.height};
+  command.color = tint;
+  commands_.push_back(command);
+}
+
+void RenderCommandList::drawTexturePro(const Texture2D& texture,
+                                       Rectangle source, Rectangle dest,
+                                       Color tint) {
+  RenderCommand command{};
+  command.type = RenderCommandType::kTexturePro;
+  command.texture = texture;
+  command.source = source;
+  command.dest = dest;
+  command.color = tint;
+  commands_.push_back(command);
+}
+
+void RenderCommandList::drawText(std::string_view text, int x, int y,
+                                 int font_size, Color color) {
+  RenderCommand command{};
+  command.type = RenderCommandType::kText;
+  command.dest = Rectangle{(float)x, (float)y, 0, (float)font_size};
+  command.color = color;
+  command.text_offset = static_cast<uint32_t>(text_buffer_.size());
+  // Keep the terminator so backends can hand the text straight to raylib
+  text_buffer_.append(text);
+  text_buffer_.push_back('\0');
+  commands_.push_back(command);
+}
+
+void RenderCommandList::drawLine(Vector2 start, Vector2 end, float thickness,
+                                 Color color) {
+  RenderCommand command{};
+  command.type = RenderCommandType::kLine;
+  command.start = start;
+  command.end = end;
+  command.thickness = thickness;
+  command.color = color;
+  commands_.push_back(command);
+}
+
+void RenderCommandList::drawRectangle(Rectangle rectangle, Color color) {
+  RenderCommand command{};
+  command.type = RenderCommandType::kRectangle;
+  command.dest = rectangle;
+  command.color = color;
+  commands_.push_back(command);
+}
+
+void RenderCommandList::beginCamera(const Camera2D& camera) {
+  RenderCommand command{};
+  command.type = RenderCommandType::kBeginCamera;
+  command.start = camera.target;
+  command.end = camera.offset;
+  command.thickness = camera.zoom;
+  commands_.push_back(command);
+}
+
+void RenderCommandList::endCamera() {
+  RenderCommand command{};
+  command.type = RenderCommandType::kEndCamera;
+  commands_.push_back(command);
+}
+
+const char* RenderCommandList::getText(const RenderCommand& command) const {
+  CHECK(command.type == RenderCommandType::kText,
+        "getText called on a non text render command");
+  return text_buffer_.data() + command.text_offset;
+}
+
+}  // namespace platformer2d
@@ -1,67 +1,113 @@
 #include "scenes/level_editor.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <limits>
+#include <string>
 
 #include "constants.h"
 #include "debug.h"
+#include "level/level_file.h"
 #include "managers/asset_manager.h"
 #include "managers/input_manager.h"
-#include "nlohmann/json.hpp"
+#include "profiling/profiler.h"
 #include "raylib.h"
 #include "scenes/scene.h"
 
 namespace platformer2d {
 
-constexpr size_t kNumTilesX = (size_t)(kScreenWidth / kTileSize);
-constexpr size_t kNumTilesY = (size_t)(kScreenHeight / kTileSize);
+// Only painted chunks take memory so the map can be far bigger than the view
+constexpr size_t kNumTilesX{4096};
+constexpr size_t kNumTilesY{4096};
+constexpr float kAutosaveSeconds{30.0f};
+// Screen pixels per second, so panning feels the same at any zoom
+constexpr float kPanSpeed{600.0f};
+// Zoom factor per mouse wheel notch
+constexpr float kZoomStep{1.25f};
+constexpr float kMinZoom{0.125f};
+constexpr float kMaxZoom{2.0f};
+// Cells a running flood fill covers each update, keeps a fill of a huge
+// area from stalling the editor
+constexpr size_t kFloodFillCellsPerUpdate{1 << 18};
 
 // Forward declare free helpers
-void drawGrid();
+const char* getEditorToolName(EditorTool tool);
+void drawGrid(RenderCommandList& commands, const TileMap& tile_map,
+              const Rectangle& view, float zoom);
 
 LevelEditor::LevelEditor(AssetManager& asset_manager,
                          InputManager& input_manager)
     : Scene("editor", SKYBLUE, asset_manager, input_manager),
       tile_map_{kNumTilesX, kNumTilesY, asset_manager},
-      tile_picker_{asset_manager} {}
+      tile_picker_{asset_manager},
+      saver_{kLevelJsonPath, kLevelBinaryPath} {}
 
 void LevelEditor::init() {
+  PROFILE_SCOPE("LevelEditor::init");
+  // The picker offers every tile so all of them are needed
+  const auto& textures = asset_manager_.getTextures();
+  for (size_t handle = 0; handle < textures.size(); ++handle) {
+    if (textures[handle].name.starts_with("tile_")) {
+      acquireTexture(static_cast<TextureHandle>(handle));
+    }
+  }
   tile_picker_.init();
-  nlohmann::json level_json;
-  std::ifstream file{"assets/levels/level_editor.json"};
-  if (!file.is_open()) {
-    DLOG("No level file found, starting with empty tile map");
-    return;
+  LevelFile binary;
+  if (isBinaryLevelCurrent(kLevelJsonPath, kLevelBinaryPath) &&
+      binary.open(kLevelBinaryPath)) {
+    tile_map_.fromLevelData(binary.toData());
+  } else {
+    std::ifstream file{kLevelJsonPath};
+    if (!file.is_open()) {
+      DLOG("No level file found, starting with empty tile map");
+    } else if (!tile_map_.fromJson(file)) {
+      DLOG("Malformed level file, tile map may be incomplete");
+    }
   }
-  file >> level_json;
-  tile_map_.fromJson(level_json["tile_map"]);
+  // Only edits from here on need saving
+  tile_map_.clearDirty();
 }
 
-void LevelEditor::update() {
+void LevelEditor::update(float delta_time) {
+  PROFILE_SCOPE("LevelEditor::update");
   // Update the level editor
   handleInput();
+  moveCamera(delta_time);
+  if (tile_map_.isFloodFilling()) {
+    tile_map_.continueFloodFill(kFloodFillCellsPerUpdate);
+  }
+
+  since_save_ += delta_time;
+  if (since_save_ >= kAutosaveSeconds) {
+    since_save_ = 0;
+    if (tile_map_.hasChanges() || saver_.hasFailed()) {
+      DLOG("Autosaving level");
+      save();
+    }
+  }
 }
 
 void LevelEditor::handleInput() {
   // Handle mouse input for the level editor
   if (input_manager_.mouseClicked()) {
-    const size_t tile_count_x =
-        (input_manager_.getMousePositionX() / kTileSize);
-    const size_t tile_count_y =
-        (input_manager_.getMousePositionY() / kTileSize);
-    // Check if the tile is on the tile editor grid
-    if (tile_count_x < tile_map_.getTiles()[0].size() &&
-        tile_count_y < tile_map_.getTiles().size()) {
-      const float pos_x = tile_count_x * kTileSize;
-      const float pos_y = tile_count_y * kTileSize;
-      bool added = tile_map_.addTile(tile_count_x, tile_count_y, pos_x, pos_y,
-                                     tile_picker_.getCurrentTextureName());
-      if (!added) {
-        PANIC("Tile at " << tile_count_x << ", " << tile_count_y
-                         << " is out of bounds");
+    const int mouse_x = input_manager_.getMousePositionX();
+    const int mouse_y = input_manager_.getMousePositionY();
+    if (mouse_x < kScreenWidth) {
+      // Clicks in the viewport land on the map under the camera
+      const float world_x = camera_.target.x + mouse_x / camera_.zoom;
+      const float world_y = camera_.target.y + mouse_y / camera_.zoom;
+      const float tile_x =
+          std::floor((world_x - tile_map_.getOriginX()) / kTileSize);
+      const float tile_y =
+          std::floor((world_y - tile_map_.getOriginY()) / kTileSize);
+      // Zoomed out past the map's edge there is nothing to paint
+      if (tile_x >= 0 && tile_y >= 0 && tile_x < tile_map_.getMaxTilesX() &&
+          tile_y < tile_map_.getMaxTilesY()) {
+        applyTool(static_cast<size_t>(tile_x), static_cast<size_t>(tile_y));
       }
     } else {
-      tile_picker_.setCurrentTextureName(input_manager_.getMousePositionX(),
-                                         input_manager_.getMousePositionY());
+      tile_picker_.setCurrentTexture(mouse_x, mouse_y);
     }
   }
 
@@ -69,42 +115,177 @@ void LevelEditor::handleInput() {
   if (input_manager_.isSPressed()) {
     save();
   }
+  if (input_manager_.isTPressed()) {
+    corner_.reset();
+    tool_ = static_cast<EditorTool>((static_cast<int>(tool_) + 1) %
+                                    (static_cast<int>(EditorTool::kPaste) + 1));
+    // Nothing to paste until something is copied
+    if (tool_ == EditorTool::kPaste && clipboard_.textures.empty()) {
+      tool_ = EditorTool::kPaint;
+    }
+  }
+}
+
+void LevelEditor::applyTool(size_t tile_x, size_t tile_y) {
+  const TextureHandle texture = tile_picker_.getCurrentTexture();
+  switch (tool_) {
+    case EditorTool::kPaint:
+      tile_map_.addTile(tile_x, tile_y, texture);
+      break;
+    case EditorTool::kFloodFill:
+      tile_map_.floodFill(tile_x, tile_y, texture);
+      break;
+    case EditorTool::kPaste:
+      tile_map_.pasteRegion(clipboard_, tile_x, tile_y);
+      break;
+    case EditorTool::kRectangle:
+    case EditorTool::kCopy: {
+      if (!corner_) {
+        corner_ = Cell{tile_x, tile_y};
+        break;
+      }
+      const TileRange range{std::min(tile_x, corner_->x),
+                            std::min(tile_y, corner_->y),
+                            std::max(tile_x, corner_->x) + 1,
+                            std::max(tile_y, corner_->y) + 1};
+      corner_.reset();
+      if (tool_ == EditorTool::kRectangle) {
+        tile_map_.fillRect(range, texture);
+      } else {
+        clipboard_ = tile_map_.copyRegion(range);
+        tool_ = EditorTool::kPaste;
+      }
+      break;
+    }
+  }
 }
 
-void LevelEditor::draw() const {
-  ClearBackground(background_color_);
-  DrawText("Level Editor e to toggle mode and s to save", 10, 10, 15, BLACK);
+void LevelEditor::draw(RenderCommandList& commands) const {
+  PROFILE_SCOPE("LevelEditor::draw");
+  commands.clearBackground(background_color_);
 
+  const Rectangle view = getView();
+  commands.beginCamera(camera_);
   // Draw the tile map as a grid
-  drawGrid();
+  drawGrid(commands, tile_map_, view, camera_.zoom);
 
   // Draw in the placed tiles
-  tile_map_.draw();
+  tile_map_.draw(commands, view);
+  if (corner_) {
+    commands.drawRectangle(
+        Rectangle{tile_map_.getOriginX() + corner_->x * kTileSize,
+                  tile_map_.getOriginY() + corner_->y * kTileSize, kTileSize,
+                  kTileSize},
+        Color{255, 255, 255, 120});
+  }
+  commands.endCamera();
+
+  // Tiles cut by the viewport's edge would otherwise show under the picker
+  commands.drawRectangle(Rectangle{(float)kScreenWidth, 0,
+                                   (float)kTilePickerWidth, kScreenHeight},
+                         background_color_);
+  commands.drawText(
+      "Level Editor e to toggle mode, s to save, arrows pan, wheel zooms", 10,
+      10, 15, BLACK);
+  commands.drawText(
+      std::string{"t to change tool: "} + getEditorToolName(tool_), 10, 30, 15,
+      BLACK);
 
   // Draw the tile picker
-  tile_picker_.draw();
+  tile_picker_.draw(commands);
 }
 
-void LevelEditor::save() const {
-  // convert tile map to json using nlohmann
-  nlohmann::json json;
-  json["tile_map"] = tile_map_.toJson();
-  std::ofstream file("assets/levels/level_editor.json");
-  if (!file.is_open()) {
-    PANIC("Failed to open file for saving");
+void LevelEditor::save() {
+  PROFILE_SCOPE("LevelEditor::save");
+  // Save the fill the user asked for, not part of it
+  tile_map_.continueFloodFill(std::numeric_limits<size_t>::max());
+  saver_.save(tile_map_);
+  since_save_ = 0;
+}
+
+void LevelEditor::onExit() { saver_.flush(); }
+
+void LevelEditor::moveCamera(float delta_time) {
+  const float pan = kPanSpeed * delta_time / camera_.zoom;
+  if (input_manager_.isLeft()) camera_.target.x -= pan;
+  if (input_manager_.isRight()) camera_.target.x += pan;
+  if (input_manager_.isUp()) camera_.target.y -= pan;
+  if (input_manager_.isDown()) camera_.target.y += pan;
+
+  const float wheel = input_manager_.getMouseWheel();
+  if (wheel != 0) {
+    // Zoom about the middle of the viewport
+    const float center_x = camera_.target.x + kScreenWidth / 2 / camera_.zoom;
+    const float center_y = camera_.target.y + kScreenHeight / 2 / camera_.zoom;
+    camera_.zoom = std::clamp(camera_.zoom * std::pow(kZoomStep, wheel),
+                              kMinZoom, kMaxZoom);
+    camera_.target.x = center_x - kScreenWidth / 2 / camera_.zoom;
+    camera_.target.y = center_y - kScreenHeight / 2 / camera_.zoom;
   }
-  file << json;
-  file.close();
-  DLOG("Saved level to assets/levels/level_editor.json");
+  clampCamera();
+}
+
+void LevelEditor::clampCamera() {
+  const Rectangle view = getView();
+  const float map_width = tile_map_.getMaxTilesX() * kTileSize;
+  const float map_height = tile_map_.getMaxTilesY() * kTileSize;
+  camera_.target.x = std::max(
+      tile_map_.getOriginX(),
+      std::min(camera_.target.x,
+               tile_map_.getOriginX() + map_width - view.width));
+  camera_.target.y = std::max(
+      tile_map_.getOriginY(),
+      std::min(camera_.target.y,
+               tile_map_.getOriginY() + map_height - view.height));
+}
+
+Rectangle LevelEditor::getView() const {
+  return Rectangle{camera_.target.x, camera_.target.y,
+                   kScreenWidth / camera_.zoom, kScreenHeight / camera_.zoom};
 }
 
 // Free helper Methods
-void drawGrid() {
-  for (int x = 0; x < kScreenWidth; x += kTileSize) {
-    DrawLine(x, 0, x, kScreenHeight, BLACK);
+const char* getEditorToolName(EditorTool tool) {
+  switch (tool) {
+    case EditorTool::kPaint:
+      return "paint";
+    case EditorTool::kRectangle:
+      return "rectangle";
+    case EditorTool::kFloodFill:
+      return "flood fill";
+    case EditorTool::kCopy:
+      return "copy";
+    case EditorTool::kPaste:
+      return "paste";
+  }
+  return "";
+}
+
+// Only the lines of the visible columns and rows, clipped to the map, so the
+// cost follows the view and not the map size
+void drawGrid(RenderCommandList& commands, const TileMap& tile_map,
+              const Rectangle& view, float zoom) {
+  const TileRange range = tile_map.getVisibleTiles(view);
+  if (range.start_x == range.end_x || range.start_y == range.end_y) return;
+  const float origin_x = tile_map.getOriginX();
+  const float origin_y = tile_map.getOriginY();
+  const float top = std::max(view.y, origin_y);
+  const float bottom = std::min(
+      view.y + view.height, origin_y + tile_map.getMaxTilesY() * kTileSize);
+  const float left = std::max(view.x, origin_x);
+  const float right = std::min(view.x + view.width,
+                               origin_x + tile_map.getMaxTilesX() * kTileSize);
+  // A screen pixel wide whatever the zoom
+  const float thickness = 1 / zoom;
+  for (size_t x = range.start_x; x < range.end_x; ++x) {
+    const float line_x = origin_x + x * kTileSize;
+    commands.drawLine(Vector2{line_x, top}, Vector2{line_x, bottom},
+                      thickness, BLACK);
   }
-  for (int y = 0; y < kScreenHeight; y += kTileSize) {
-    DrawLine(0, y, kScreenWidth, y, BLACK);
+  for (size_t y = range.start_y; y < range.end_y; ++y) {
+    const float line_y = origin_y + y * kTileSize;
+    commands.drawLine(Vector2{left, line_y}, Vector2{right, line_y},
+                      thickness, BLACK);
   }
 }
 
@@ -2,11 +2,14 @@
 
 #include <fstream>
 #include <string>
+#include <unordered_set>
 
 #include "components/animation_component.h"
 #include "components/movement_component.h"
 #include "constants.h"
-#include "nlohmann/json.hpp"
+#include "level/level_file.h"
+#include "level/level_json_reader.h"
+#include "profiling/profiler.h"
 #include "raylib.h"
 #include "scenes/scene.h"
 
@@ -14,60 +17,317 @@ namespace platformer2d {
 
 const std::string playerTag{"player"};
 
-LevelScene::LevelScene(AssetManager& asset_manager, InputManager& input_manager)
+LevelScene::LevelScene(AssetManager& asset_manager, InputManager& input_manager,
+                       const AnimationLibrary& animation_library)
     : Scene("level", SKYBLUE, asset_manager, input_manager),
+      animation_library_{animation_library},
       physics_{},
       animation_system_{animation_components_, position_components_,
-                        movement_components_, asset_manager_},
-      animation_state_system_{animation_components_, movement_components_},
+                        movement_components_, animation_library_,
+                        asset_manager_},
+      animation_state_system_{animation_components_, movement_components_,
+                              animation_library_},
       render_system_{position_components_, render_components_, asset_manager_} {
 }
 
 void LevelScene::init() {
+  PROFILE_SCOPE("LevelScene::init");
   initPlayer();
   loadLevelFromFile();
   physics_.init(movement_components_, position_components_,
                 collision_components_);
+  animation_state_system_.init();
+  animation_system_.init();
 }
 
-void LevelScene::loadLevelFromFile() {
-  std::string level_file_path{"assets/levels/level_editor.json"};
-  std::ifstream file{level_file_path};
-  if (!file.is_open()) {
-    DLOG("Failed to open level file! Loading empty level");
+void LevelScene::onFileChanged(const std::string& path) {
+  if (path != kLevelJsonPath && path != kLevelBinaryPath &&
+      path != kLevelBakedPath) {
     return;
   }
-  DLOG("Loading level from file: " << level_file_path);
-  nlohmann::json level_json;
-  file >> level_json;
-  // Create components from the json objects
-  int counter{0};
-  for (const auto& tile_row : level_json["tile_map"]["tiles"]) {
-    for (const auto& tile : tile_row) {
-      if (tile["texture_name"] == "") {
-        continue;
-      }
-      ++counter;
-      const std::string tile_tag{"tile_" + std::to_string(counter)};
-      render_components_.emplace(
-          tile_tag, RenderComponent{tile_tag, tile["texture_name"]});
-      position_components_.emplace(
-          tile_tag, PositionComponent{tile_tag, tile["x"], tile["y"]});
-      collision_components_.emplace(
-          tile_tag, CollisionComponent{tile_tag, kTileSize, kTileSize, 0, 0});
-
-      // This feels a bit hacky later on will want to be able to add
-      // characteristics to the tile in the level editor or tile picker but now
-      // just add directly here
-      if (tile["texture_name"] == "tile_winter_ice") {
-        MovementComponent mover{tile_tag};
-        mover.mass = 20.0f;
-        mover.friction_coefficient = 20.0f;
-        mover.is_grounded = true;
-        movement_components_.emplace(tile_tag, mover);
-      }
+  DLOG("Level file changed, reloading changed tiles");
+  if (loadLevelFromFile() == 0) return;
+  // Tiles were added or removed so the physics references need gathering
+  physics_.init(movement_components_, position_components_,
+                collision_components_);
+  asset_manager_.startLoading();
+}
+
+SceneStats LevelScene::getStats() const {
+  const PhysicsStats& physics = physics_.getStats();
+  return SceneStats{position_components_.size(), physics.colliders,
+                    physics.collision_pairs};
+}
+
+size_t LevelScene::loadLevelFromFile() {
+  PROFILE_SCOPE("LevelScene::loadLevelFromFile");
+  // Tiles are tagged by grid cell so an edit only touches its own cells
+  std::unordered_set<std::string> in_file;
+  size_t changed{removeBakedColliders()};
+  if (openBakedLevel()) {
+    // Everything is precomputed, there is nothing to do per tile
+    DLOG("Loading baked level from file: " << kLevelBakedPath);
+    streamer_.close();
+    chunk_tiles_.clear();
+    chunks_to_unload_.clear();
+    changed += addBakedLevel(in_file);
+  } else if (isBinaryLevelCurrent(kLevelJsonPath, kLevelBinaryPath) &&
+             streamer_.open(kLevelBinaryPath)) {
+    // Only the chunks around the player, the rest stream in as it moves
+    DLOG("Streaming level from file: " << kLevelBinaryPath);
+    // The palette is small and known up front, so loading all of it now
+    // means chunks streamed in during play never wait on a texture
+    for (const auto& texture_name : streamer_.getTextureNames()) {
+      acquireTexture(asset_manager_.getHandle(std::string{texture_name}));
+    }
+    const PositionComponent& player = getComponentOrPanic<PositionComponent>(
+        position_components_, playerTag);
+    chunk_tiles_.clear();
+    chunks_to_unload_.clear();
+    for (const auto& chunk : streamer_.loadAround(player.x, player.y)) {
+      changed += applyChunk(chunk);
+      const auto& tile_tags = chunk_tiles_[chunk.coord.getKey()];
+      in_file.insert(tile_tags.begin(), tile_tags.end());
+    }
+    // Moving tiles leave the chunk they start in, so like the baked level's
+    // they are all loaded now and never streamed
+    for (const auto& tile : streamer_.findTiles(kMovingTileTexture)) {
+      changed += syncTile(tile.grid_x, tile.grid_y, tile.texture_name, tile.x,
+                          tile.y, in_file);
+    }
+  } else {
+    streamer_.close();
+    chunk_tiles_.clear();
+    chunks_to_unload_.clear();
+    std::ifstream file{kLevelJsonPath};
+    if (!file.is_open()) {
+      DLOG("Failed to open level file! Loading empty level");
+      return 0;
+    }
+    DLOG("Loading level from file: " << kLevelJsonPath);
+    // Tiles are synced as they are parsed, the document is never built
+    const bool complete = readLevelJson(file, [&](const LevelJsonCell& cell) {
+      if (cell.texture_name.empty()) return;
+      changed += syncTile(cell.grid_x, cell.grid_y, cell.texture_name, cell.x,
+                          cell.y, in_file);
+    });
+    // Likely caught half written, the finished write triggers another load.
+    // Keep the tiles not read yet rather than dropping them.
+    if (!complete) {
+      DLOG("Malformed level file, keeping the rest of the current level");
+      return changed;
     }
   }
+
+  std::vector<std::string> removed;
+  for (const auto& [tile_tag, tile] : level_tiles_) {
+    if (!in_file.contains(tile_tag)) {
+      removed.push_back(tile_tag);
+    }
+  }
+  for (const auto& tile_tag : removed) {
+    removeTile(tile_tag);
+  }
+  return changed + removed.size();
+}
+
+size_t LevelScene::syncTile(size_t x, size_t y, std::string_view texture_name,
+                            float pos_x, float pos_y,
+                            std::unordered_set<std::string>& in_file) {
+  const std::string tile_tag{"tile_" + std::to_string(x) + "_" +
+                             std::to_string(y)};
+  auto existing = level_tiles_.find(tile_tag);
+  const bool unchanged = existing != level_tiles_.end() &&
+                         existing->second.texture_name == texture_name &&
+                         existing->second.x == pos_x &&
+                         existing->second.y == pos_y;
+  in_file.insert(tile_tag);
+  if (unchanged) return 0;
+  removeTile(tile_tag);
+  addTile(tile_tag, LevelTile{std::string{texture_name}, pos_x, pos_y});
+  return 1;
+}
+
+bool LevelScene::openBakedLevel() {
+  if (!isBinaryLevelCurrent(kLevelJsonPath, kLevelBakedPath) ||
+      !baked_.open(kLevelBakedPath)) {
+    baked_.close();
+    return false;
+  }
+  if (!baked_.matches(asset_manager_)) {
+    DLOG("Baked level was built against other textures, ignoring it");
+    baked_.close();
+    return false;
+  }
+  return true;
+}
+
+size_t LevelScene::addBakedLevel(std::unordered_set<std::string>& in_file) {
+  for (const auto& texture : baked_.getTextures()) {
+    acquireTexture(texture.handle);
+  }
+  const PositionComponent& player =
+      getComponentOrPanic<PositionComponent>(position_components_, playerTag);
+  baked_chunks_.reset(baked_.getNumChunksX(), baked_.getNumChunksY());
+  size_t changed{updateBakedChunks(player.x, player.y)};
+  for (const auto& tile : baked_.getMovingTiles()) {
+    changed += syncTile(tile.grid_x, tile.grid_y,
+                        asset_manager_.getName(tile.texture), tile.x, tile.y,
+                        in_file);
+  }
+  return changed;
+}
+
+size_t LevelScene::updateBakedChunks(float focus_x, float focus_y) {
+  std::vector<LevelChunkCoord> loaded;
+  std::vector<LevelChunkCoord> unloaded;
+  baked_chunks_.update(baked_.getChunkCoord(focus_x, focus_y), loaded,
+                       unloaded);
+  size_t changed{0};
+  for (const auto& coord : unloaded) {
+    changed += removeBakedChunk(coord);
+  }
+  // Only a few merged rectangles each, read from the mapping, so all of
+  // them are made straight away
+  for (const auto& coord : loaded) {
+    changed += addBakedChunk(coord);
+  }
+  return changed;
+}
+
+size_t LevelScene::addBakedChunk(const LevelChunkCoord& coord) {
+  const BakedChunk* chunk = baked_.findChunk(coord);
+  if (!chunk) return 0;
+  const auto colliders =
+      baked_.getColliders().subspan(chunk->first_collider,
+                                    chunk->num_colliders);
+  for (size_t i = 0; i < colliders.size(); ++i) {
+    const std::string collider_tag{
+        "collider_" + std::to_string(chunk->first_collider + i)};
+    position_components_.emplace(
+        collider_tag,
+        PositionComponent{collider_tag, colliders[i].x, colliders[i].y});
+    collision_components_.emplace(
+        collider_tag, CollisionComponent{collider_tag, colliders[i].width,
+                                         colliders[i].height});
+  }
+  return colliders.size();
+}
+
+size_t LevelScene::removeBakedChunk(const LevelChunkCoord& coord) {
+  const BakedChunk* chunk = baked_.findChunk(coord);
+  if (!chunk) return 0;
+  for (uint32_t i = 0; i < chunk->num_colliders; ++i) {
+    const std::string collider_tag{
+        "collider_" + std::to_string(chunk->first_collider + i)};
+    position_components_.erase(collider_tag);
+    collision_components_.erase(collider_tag);
+  }
+  return chunk->num_colliders;
+}
+
+size_t LevelScene::removeBakedColliders() {
+  // Before the baked level is reopened, the chunks' ranges come from the
+  // file their colliders were made from
+  size_t removed{0};
+  for (const uint64_t key : baked_chunks_.getChunks()) {
+    removed += removeBakedChunk(LevelChunkCoord::fromKey(key));
+  }
+  baked_chunks_.reset(0, 0);
+  return removed;
+}
+
+size_t LevelScene::applyChunk(const LevelChunk& chunk) {
+  std::unordered_set<std::string> in_chunk;
+  size_t changed{0};
+  for (const auto& tile : chunk.tiles) {
+    if (tile.texture_name == kMovingTileTexture) continue;
+    changed += syncTile(tile.grid_x, tile.grid_y, tile.texture_name, tile.x,
+                        tile.y, in_chunk);
+  }
+  auto& tile_tags = chunk_tiles_[chunk.coord.getKey()];
+  for (const auto& tile_tag : tile_tags) {
+    if (!in_chunk.contains(tile_tag)) {
+      removeTile(tile_tag);
+      ++changed;
+    }
+  }
+  tile_tags.assign(in_chunk.begin(), in_chunk.end());
+  // Back in range before its unload came round
+  std::erase(chunks_to_unload_, chunk.coord);
+  return changed;
+}
+
+size_t LevelScene::unloadChunk(const LevelChunkCoord& coord) {
+  auto it = chunk_tiles_.find(coord.getKey());
+  if (it == chunk_tiles_.end()) return 0;
+  for (const auto& tile_tag : it->second) {
+    removeTile(tile_tag);
+  }
+  const size_t removed = it->second.size();
+  chunk_tiles_.erase(it);
+  return removed;
+}
+
+void LevelScene::streamLevel() {
+  PROFILE_SCOPE("LevelScene::streamLevel");
+  if (baked_.isOpen()) {
+    const PositionComponent& player = getComponentOrPanic<PositionComponent>(
+        position_components_, playerTag);
+    if (updateBakedChunks(player.x, player.y) > 0) {
+      physics_.init(movement_components_, position_components_,
+                    collision_components_);
+    }
+    return;
+  }
+  if (!streamer_.isOpen()) return;
+  const PositionComponent& player =
+      getComponentOrPanic<PositionComponent>(position_components_, playerTag);
+  streamer_.update(player.x, player.y, chunks_to_unload_);
+  size_t changed{0};
+  if (!chunks_to_unload_.empty()) {
+    changed += unloadChunk(chunks_to_unload_.back());
+    chunks_to_unload_.pop_back();
+  }
+  LevelChunk chunk;
+  if (streamer_.popLoadedChunk(chunk)) {
+    changed += applyChunk(chunk);
+  }
+  // The chunks' textures were acquired with the level so none are queued
+  if (changed == 0) return;
+  physics_.init(movement_components_, position_components_,
+                collision_components_);
+}
+
+void LevelScene::addTile(const std::string& tile_tag, const LevelTile& tile) {
+  // Only the textures this level uses get loaded
+  const TextureHandle texture{asset_manager_.getHandle(tile.texture_name)};
+  acquireTexture(texture);
+  render_components_.emplace(tile_tag, RenderComponent{tile_tag, texture});
+  position_components_.emplace(tile_tag,
+                               PositionComponent{tile_tag, tile.x, tile.y});
+  collision_components_.emplace(
+      tile_tag, CollisionComponent{tile_tag, kTileSize, kTileSize, 0, 0});
+
+  // This feels a bit hacky later on will want to be able to add
+  // characteristics to the tile in the level editor or tile picker but now
+  // just add directly here
+  if (tile.texture_name == kMovingTileTexture) {
+    MovementComponent mover{tile_tag};
+    mover.mass = 20.0f;
+    mover.friction_coefficient = 20.0f;
+    mover.is_grounded = true;
+    movement_components_.emplace(tile_tag, mover);
+  }
+  level_tiles_.insert_or_assign(tile_tag, tile);
+}
+
+void LevelScene::removeTile(const std::string& tile_tag) {
+  render_components_.erase(tile_tag);
+  position_components_.erase(tile_tag);
+  collision_components_.erase(tile_tag);
+  movement_components_.erase(tile_tag);
+  level_tiles_.erase(tile_tag);
 }
 
 void LevelScene::initPlayer() {
@@ -77,39 +337,60 @@ void LevelScene::initPlayer() {
   movement_components_.emplace(playerTag, MovementComponent{playerTag});
   collision_components_.emplace(playerTag,
                                 CollisionComponent{playerTag, 20, 40, 10, 0});
-  AnimationComponent player_animation{playerTag, 1.3f};
-  player_animation.current_state = AnimationState::kIdle;
-  player_animation.setStateToNumFrames(AnimationState::kIdle, 4);
-  player_animation.setStateToNumFrames(AnimationState::kRunning, 6);
-  player_animation.setStateToTextureName(AnimationState::kIdle,
-                                         "pink_monster_idle");
-  player_animation.setStateToTextureName(AnimationState::kRunning,
-                                         "pink_monster_run");
-  player_animation.setStateToAnimationFPS(AnimationState::kIdle, 0.4f);
-  player_animation.setStateToAnimationFPS(AnimationState::kRunning, 0.4f);
-  animation_components_.emplace(playerTag, player_animation);
-}
-
-void LevelScene::update() {
+  const AnimationStateMachineId player_machine{
+      animation_library_.getStateMachineId("pink_monster")};
+  animation_components_.emplace(
+      playerTag,
+      AnimationComponent{
+          playerTag, player_machine,
+          animation_library_.getStateMachine(player_machine).initial_state,
+          1.3f});
+}
+
+void LevelScene::update(float delta_time) {
+  PROFILE_SCOPE("LevelScene::update");
+  streamLevel();
   handleInput();
-  physics_.update();
+  physics_.update(delta_time);
   animation_state_system_.update();
-  animation_system_.update();
+  animation_system_.update(delta_time);
 }
 
-void LevelScene::draw() const {
-  ClearBackground(background_color_);
+void LevelScene::draw(RenderCommandList& commands) const {
+  PROFILE_SCOPE("LevelScene::draw");
+  commands.clearBackground(background_color_);
 
 #ifndef NDEBUG
   // Draw some debug info
-  DrawText("DEBUG mode press e to toggle editor", 10, 10, 15, BLACK);
+  commands.drawText("DEBUG mode press e to toggle editor", 10, 10, 15, BLACK);
 #endif
 
+  // Static tiles of a baked level, straight from the mapped lists of the
+  // chunks in view. The level is drawn without a camera so the view is the
+  // screen.
+  if (baked_.isOpen()) {
+    const auto sprites = baked_.getSprites();
+    const LevelChunkCoord first = baked_.getChunkCoord(0, 0);
+    const LevelChunkCoord last =
+        baked_.getChunkCoord(kScreenWidth, kScreenHeight);
+    for (int32_t y = first.y; y <= last.y; ++y) {
+      for (int32_t x = first.x; x <= last.x; ++x) {
+        const BakedChunk* chunk = baked_.findChunk(LevelChunkCoord{x, y});
+        if (!chunk) continue;
+        for (const auto& sprite :
+             sprites.subspan(chunk->first_sprite, chunk->num_sprites)) {
+          commands.drawTexture(asset_manager_.getTexture(sprite.texture),
+                               sprite.x, sprite.y, WHITE);
+        }
+      }
+    }
+  }
+
   // Draw static components (Tiles)
-  render_system_.draw();
+  render_system_.draw(commands);
 
   // Draw animations (Sprites)
-  animation_system_.draw();
+  animation_system_.draw(commands);
 }
 
 void LevelScene::handleInput() {
@@ -0,0 +1,46 @@
+#include "scenes/loading_scene.h"
+
+#include <string>
+
+#include "constants.h"
+#include "raylib.h"
+
+namespace platformer2d {
+
+// Leave most of the frame for presenting so the window stays responsive
+constexpr double kUploadBudgetSeconds{0.004};
+
+LoadingScene::LoadingScene(AssetManager& asset_manager,
+                           InputManager& input_manager)
+    : Scene("loading", RAYWHITE, asset_manager, input_manager) {}
+
+void LoadingScene::init() {}
+
+void LoadingScene::update(float /*delta_time*/) {
+  asset_manager_.uploadPendingTextures(kUploadBudgetSeconds);
+}
+
+void LoadingScene::draw(RenderCommandList& commands) const {
+  const LoadingProgress progress = asset_manager_.getLoadingProgress();
+  const float fraction =
+      progress.total == 0 ? 1.0f : (float)progress.uploaded / progress.total;
+
+  commands.clearBackground(background_color_);
+  commands.drawText("Loading " + std::to_string(progress.uploaded) + " / " +
+                        std::to_string(progress.total),
+                    kScreenWidth / 2 - 60, kScreenHeight / 2 - 40, 20, BLACK);
+
+  const Rectangle bar{kScreenWidth / 4.0f, kScreenHeight / 2.0f,
+                      kScreenWidth / 2.0f, 20.0f};
+  commands.drawRectangle(bar, LIGHTGRAY);
+  commands.drawRectangle(
+      Rectangle{bar.x, bar.y, bar.width * fraction, bar.height}, DARKGRAY);
+}
+
+bool LoadingScene::isDone() const {
+  return asset_manager_.getLoadingProgress().isComplete();
+}
+
+void LoadingScene::handleInput() {}
+
+}  // namespace platformer2d
@@ -1,24 +1,57 @@
 #include "systems/animation_state_system.h"
 
+#include <cstdint>
+
+#include "profiling/profiler.h"
+
 namespace platformer2d {
 
 AnimationStateSystem::AnimationStateSystem(
     std::unordered_map<std::string, AnimationComponent>& animations,
-    std::unordered_map<std::string, MovementComponent>& movements)
-    : animations_(animations), movements_(movements) {
+    std::unordered_map<std::string, MovementComponent>& movements,
+    const AnimationLibrary& library)
+    : animations_(animations), movements_(movements), library_(library) {}
+
+void AnimationStateSystem::init() {
+  movers_.clear();
+  for (auto& [entity_id, animation] : animations_) {
+    movers_.emplace_back(animation,
+                         getComponentOrPanic(movements_, entity_id));
+  }
+  conditions_.resize(movers_.size());
 }
 
 void AnimationStateSystem::update() {
-  // TODO: Remove this and think of a better way to handle this
-  // This works for player but not for enemies. Will likely need
-  // to have a field `type` for the different types of characters and
-  // then have a different set of rules for each type of character
-  MovementComponent& movement = movements_.at("player");
-  if (movement.velocity_x != 0 && movement.is_grounded) {
-    animations_.at("player").current_state = AnimationState::kRunning;
-  } else {
-    animations_.at("player").current_state = AnimationState::kIdle;
+  PROFILE_SCOPE("AnimationStateSystem::update");
+  // Pass 1: condition bits for every entity
+  for (size_t i = 0; i < movers_.size(); ++i) {
+    const MovementComponent& movement = movers_[i].movement;
+    uint8_t conditions{0};
+    conditions |= movement.velocity_x != 0 ? kConditionMoving : 0;
+    conditions |= movement.is_grounded ? kConditionGrounded : 0;
+    conditions |= movement.is_facing_right ? kConditionFacingRight : 0;
+    // Screen space y grows downwards
+    conditions |= movement.velocity_y < 0 ? kConditionRising : 0;
+    conditions |= movement.velocity_y > 0 ? kConditionFalling : 0;
+    conditions_[i] = conditions;
+  }
+
+  // Pass 2: take the first matching transition out of each current state
+  for (size_t i = 0; i < movers_.size(); ++i) {
+    AnimationComponent& animation = movers_[i].animation;
+    const AnimationStateMachine& machine =
+        library_.getStateMachine(animation.state_machine);
+    const AnimationMachineState& state =
+        library_.getState(machine, animation.current_state);
+    const uint32_t end = state.first_transition + state.num_transitions;
+    for (uint32_t t = state.first_transition; t < end; ++t) {
+      const AnimationTransition& transition = library_.getTransition(t);
+      if ((conditions_[i] & transition.mask) == transition.value) {
+        animation.current_state = transition.to_state;
+        break;
+      }
+    }
   }
 }
 
-}  // namespace platformer2d
\ No newline at end of file
+}  // namespace platformer2d
@@ -1,6 +1,6 @@
 #include "systems/animation_system.h"
 
-#include "constants.h"
+#include "profiling/profiler.h"
 #include "raylib.h"
 
 namespace platformer2d {
@@ -9,64 +9,79 @@ AnimationSystem::AnimationSystem(
     std::unordered_map<std::string, AnimationComponent>& animations,
     std::unordered_map<std::string, PositionComponent>& positions,
     std::unordered_map<std::string, MovementComponent>& movements,
-    AssetManager& assets)
+    const AnimationLibrary& library, AssetManager& assets)
     : animations_(animations),
       positions_(positions),
       movements_(movements),
-      assets_(assets),
-      frame_number_(0) {}
+      library_(library),
+      assets_(assets) {}
 
-void AnimationSystem::update() {
-  frame_number_++;
-
-  // Reset the frame number if it's too large
-  if (frame_number_ > kTargetFPS * 10) {
-    frame_number_ = 0;
+void AnimationSystem::init() {
+  sprites_.clear();
+  for (auto& [entity_id, animation] : animations_) {
+    sprites_.emplace_back(animation,
+                          getComponentOrPanic(positions_, entity_id),
+                          getComponentOrPanic(movements_, entity_id));
   }
 }
 
-void AnimationSystem::draw() const {
-  for (const auto& pair : animations_) {
-    auto& position{
-        getComponentOrPanic<PositionComponent>(positions_, pair.first)};
-    auto& movement{
-        getComponentOrPanic<MovementComponent>(movements_, pair.first)};
-    auto& animation{pair.second};
-    std::string texture_name{animation.getCurrentTextureName()};
-    Texture2D animation_frames{assets_.getTexture(texture_name)};
-    int8_t num_frames{animation.getCurrentNumFrames()};
+void AnimationSystem::update(float delta_time) {
+  PROFILE_SCOPE("AnimationSystem::update");
+  for (auto& sprite : sprites_) {
+    AnimationComponent& animation = sprite.animation;
 
-    // Update the animation frame at a rate of roughly animation_fps
-    int current_frame{static_cast<int>(
-        frame_number_ / (kTargetFPS * animation.getCurrentAnimationFPS()))};
-    current_frame %= num_frames;
+    // Restart playback when the state has switched clips
+    const AnimationClipId clip_id =
+        library_
+            .getState(library_.getStateMachine(animation.state_machine),
+                      animation.current_state)
+            .clip;
+    if (clip_id != animation.playing_clip) {
+      animation.playing_clip = clip_id;
+      animation.current_frame = 0;
+      animation.frame_time = 0.0f;
+    }
 
-    const float sprite_width = (float)animation_frames.width / num_frames;
-    const float sprite_pos_x = current_frame * sprite_width;
+    // Advance past however many frames the elapsed time covers
+    const AnimationClip& clip = library_.getClip(clip_id);
+    animation.frame_time += delta_time;
+    float frame_duration =
+        library_.getFrame(clip, animation.current_frame).duration;
+    while (animation.frame_time >= frame_duration) {
+      animation.frame_time -= frame_duration;
+      animation.current_frame = (animation.current_frame + 1) % clip.num_frames;
+      frame_duration =
+          library_.getFrame(clip, animation.current_frame).duration;
+    }
+  }
+}
 
-    Rectangle frameRec = {sprite_pos_x, 0, sprite_width,
-                          (float)animation_frames.height};
+void AnimationSystem::draw(RenderCommandList& commands) const {
+  PROFILE_SCOPE("AnimationSystem::draw");
+  for (const auto& sprite : sprites_) {
+    const AnimationComponent& animation = sprite.animation;
+    // Nothing to show until the first update picks a clip
+    if (animation.playing_clip == kInvalidAnimationClip) continue;
 
-    float scale = animation.scale;
+    const AnimationClip& clip = library_.getClip(animation.playing_clip);
+    Rectangle frameRec =
+        library_.getFrame(clip, animation.current_frame).source;
 
     // Destination rectangle (this controls the position and scaling)
     Rectangle destRec = {
-        position.x,                             // Destination X position
-        position.y,                             // Destination Y position
-        sprite_width * scale,                   // Destination width (scaled)
-        (float)animation_frames.height * scale  // Destination height (scaled)
-    };
-
-    // Origin for rotation/scaling (set to the center of the texture)
-    Vector2 origin = {0.0f, 0.0f};
+        sprite.position.x,                   // Destination X position
+        sprite.position.y,                   // Destination Y position
+        frameRec.width * animation.scale,    // Destination width (scaled)
+        frameRec.height * animation.scale};  // Destination height (scaled)
 
-    if (!movement.is_facing_right) {
+    if (!sprite.movement.is_facing_right) {
       // Flip the sprite horizontally
-      frameRec.width = -sprite_width;
+      frameRec.width = -frameRec.width;
     }
 
-    // Draw the texture using DrawTexturePro, which supports scaling
-    DrawTexturePro(animation_frames, frameRec, destRec, origin, 0.0f, WHITE);
+    // Record a DrawTexturePro style command, which supports scaling
+    commands.drawTexturePro(assets_.getTexture(clip.texture), frameRec,
+                            destRec, WHITE);
   }
 }
 
@@ -7,6 +7,7 @@
 #include "components/component.h"
 #include "components/movement_component.h"
 #include "constants.h"
+#include "profiling/profiler.h"
 #include "raylib.h"
 
 namespace platformer2d {
@@ -16,6 +17,8 @@ void PhysicsSystem::init(
     std::unordered_map<std::string, MovementComponent>& movement_components,
     std::unordered_map<std::string, PositionComponent>& position_components,
     std::unordered_map<std::string, CollisionComponent>& collision_components) {
+  mover_components_.clear();
+  collider_components_.clear();
   for (auto& [entity_id, movement] : movement_components) {
     mover_components_.emplace_back(
         movement, getComponentOrPanic(position_components, entity_id),
@@ -26,13 +29,18 @@ void PhysicsSystem::init(
         getComponentOrPanic(collision_components, entity_id),
         getComponentOrPanic(position_components, entity_id));
   }
+  stats_.movers = mover_components_.size();
+  stats_.colliders = collider_components_.size();
 }
 
-void PhysicsSystem::update() {
+void PhysicsSystem::update(float delta_time) {
+  PROFILE_SCOPE("PhysicsSystem::update");
+  stats_.collision_pairs = 0;
   for (auto& mover : mover_components_) {
     std::vector<CollisionPair> collisions = calculateCollisions(mover);
+    stats_.collision_pairs += collisions.size();
     resolveCollisions(collisions);
-    updateVelocity(mover);
+    updateVelocity(mover, delta_time);
     updatePosition(mover);
   }
 }
@@ -84,8 +92,8 @@ void PhysicsSystem::resolveCollisions(std::vector<CollisionPair>& collisions) {
   }
 }
 
-void PhysicsSystem::updateVelocity(MoverComponentAggregate& mover) {
-  const float delta_time = GetFrameTime();
+void PhysicsSystem::updateVelocity(MoverComponentAggregate& mover,
+                                   const float delta_time) {
   updateVelocityY(mover.movement, delta_time);
   updateVelocityX(mover.movement, delta_time);
 }
@@ -2,6 +2,7 @@
 
 #include <string>
 
+#include "profiling/profiler.h"
 #include "raylib.h"
 
 namespace platformer2d {
@@ -14,13 +15,13 @@ RenderSystem::RenderSystem(
       render_components_(render_components),
       assets_(assets) {}
 
-void RenderSystem::draw() const {
+void RenderSystem::draw(RenderCommandList& commands) const {
+  PROFILE_SCOPE("RenderSystem::draw");
   for (const auto& render_pair : render_components_) {
     const std::string entity_tag{render_pair.first};
     const PositionComponent& position{position_components_.at(entity_tag)};
-    const Texture2D& texture{
-        assets_.getTexture(render_pair.second.texture_name)};
-    DrawTexture(texture, position.x, position.y, WHITE);
+    const Texture2D& texture{assets_.getTexture(render_pair.second.texture)};
+    commands.drawTexture(texture, position.x, position.y, WHITE);
   }
 }
 
@@ -0,0 +1,62 @@
+// Packs every texture in the asset manifest into one bundle of pre-decoded
+// pixels that the game memory maps at startup instead of decoding pngs.
+//
+// Usage: Platformer2dAssetBundle [manifest_path] [bundle_path] [--no-compress]
+//
+// Run from the repository root (or use the asset_bundle build target).
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "managers/asset_bundle.h"
+#include "managers/asset_manifest.h"
+#include "raylib.h"
+
+using namespace platformer2d;
+
+int main(int argc, char** argv) {
+  std::vector<std::string> paths;
+  bool compress{true};
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--no-compress") == 0) {
+      compress = false;
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  const std::string manifest_path{paths.size() > 0 ? paths[0]
+                                                   : "assets/manifest.json"};
+  const std::string bundle_path{paths.size() > 1 ? paths[1]
+                                                 : "assets/textures.bundle"};
+
+  AssetManifest manifest;
+  if (!manifest.loadFromFile(manifest_path)) {
+    std::cerr << "Failed to read " << manifest_path << std::endl;
+    return 1;
+  }
+
+  SetTraceLogLevel(LOG_WARNING);
+  AssetBundleWriter writer;
+  for (const auto& asset : manifest.getEntries()) {
+    Image image = LoadImage(asset.path.c_str());
+    if (image.data == nullptr) {
+      std::cerr << "Failed to decode " << asset.path << std::endl;
+      return 1;
+    }
+    // One format for everything so the game can upload without converting
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    writer.addImage(asset.name, asset.path, asset.display_width,
+                    asset.display_height, image, compress);
+    UnloadImage(image);
+  }
+  if (!writer.write(bundle_path)) {
+    std::cerr << "Failed to write " << bundle_path << std::endl;
+    return 1;
+  }
+  std::cout << "Wrote " << manifest.getEntries().size() << " textures to "
+            << bundle_path << " (" << writer.getStoredBytes() << " of "
+            << writer.getRawBytes() << " pixel bytes)" << std::endl;
+  return 0;
+}
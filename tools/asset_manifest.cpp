@@ -0,0 +1,31 @@
+// Regenerates the asset manifest by scanning the assets directory.
+//
+// Usage: Platformer2dAssetManifest [assets_dir] [manifest_path]
+//
+// Run from the repository root (or use the asset_manifest build target).
+// Names of assets already in the manifest are kept.
+
+#include <iostream>
+#include <string>
+
+#include "managers/asset_manifest.h"
+
+using namespace platformer2d;
+
+int main(int argc, char** argv) {
+  const std::string root{argc > 1 ? argv[1] : "assets"};
+  const std::string manifest_path{argc > 2 ? argv[2]
+                                           : root + "/manifest.json"};
+
+  AssetManifest previous;
+  const bool has_previous = previous.loadFromFile(manifest_path);
+  const AssetManifest manifest =
+      AssetManifest::scan(root, has_previous ? &previous : nullptr);
+  if (!manifest.saveToFile(manifest_path)) {
+    std::cerr << "Failed to write " << manifest_path << std::endl;
+    return 1;
+  }
+  std::cout << "Wrote " << manifest.getEntries().size() << " assets to "
+            << manifest_path << std::endl;
+  return 0;
+}
@@ -0,0 +1,316 @@
+// Microbenchmarks for the engine's hot paths. Each benchmark is timed over
+// many samples of a fixed number of iterations, the per iteration time of
+// every sample goes into a histogram and the mean and percentiles of that
+// are reported. Results can also be written as json to diff across commits.
+//
+// Usage: Platformer2dBenchmark [--json FILE] [--filter TEXT]
+//                              [--min-time-ms N]
+//
+// Run from the repository root (or build the benchmark target), the level
+// and asset benchmarks read assets/.
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "components/collision_component.h"
+#include "components/component.h"
+#include "components/movement_component.h"
+#include "components/position_component.h"
+#include "constants.h"
+#include "level/level_file.h"
+#include "level_editor/tile_map.h"
+#include "managers/asset_manager.h"
+#include "managers/asset_manifest.h"
+#include "metrics/histogram.h"
+#include "nlohmann/json.hpp"
+#include "render/render_command_list.h"
+#include "systems/physics_system.h"
+
+using namespace platformer2d;
+
+constexpr char kManifestPath[]{"assets/manifest.json"};
+constexpr char kLevelPath[]{"assets/levels/level_editor.json"};
+// Samples timed before measuring, to warm caches and fault in memory
+constexpr size_t kWarmupSamples{10};
+constexpr size_t kMinSamples{50};
+constexpr size_t kMaxSamples{100000};
+
+struct BenchmarkOptions {
+  std::string filter;
+  std::chrono::milliseconds min_time{200};
+};
+
+struct BenchmarkResult {
+  std::string name;
+  uint64_t iterations{0};  // Per sample
+  uint64_t samples{0};
+  // Per iteration
+  double mean_ns{0};
+  double p50_ns{0};
+  double p95_ns{0};
+  double p99_ns{0};
+  double max_ns{0};
+};
+
+// Keeps the compiler from optimising away a result nothing reads
+template <typename T>
+void doNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Times body, which runs one iteration, in samples of iterations calls until
+// both kMinSamples and min_time are reached
+template <typename Body>
+void runBenchmark(const BenchmarkOptions& options, std::string_view name,
+                  uint64_t iterations, Body&& body,
+                  std::vector<BenchmarkResult>& results) {
+  if (name.find(options.filter) == std::string_view::npos) return;
+  using Clock = std::chrono::steady_clock;
+  Histogram sample_ns;
+  const auto start = Clock::now();
+  for (size_t sample = 0; sample < kWarmupSamples + kMaxSamples; ++sample) {
+    const auto sample_start = Clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+      body();
+    }
+    const auto sample_end = Clock::now();
+    if (sample < kWarmupSamples) continue;
+    sample_ns.record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         sample_end - sample_start)
+                         .count());
+    if (sample_ns.getCount() >= kMinSamples &&
+        sample_end - start >= options.min_time) {
+      break;
+    }
+  }
+
+  BenchmarkResult result;
+  result.name = name;
+  result.iterations = iterations;
+  result.samples = sample_ns.getCount();
+  result.mean_ns = sample_ns.getMean() / iterations;
+  result.p50_ns = (double)sample_ns.getPercentile(0.5) / iterations;
+  result.p95_ns = (double)sample_ns.getPercentile(0.95) / iterations;
+  result.p99_ns = (double)sample_ns.getPercentile(0.99) / iterations;
+  result.max_ns = (double)sample_ns.getMax() / iterations;
+  std::cout << std::left << std::setw(36) << result.name << std::right
+            << std::fixed << std::setprecision(1) << std::setw(12)
+            << result.mean_ns << std::setw(12) << result.p50_ns
+            << std::setw(12) << result.p95_ns << std::setw(12)
+            << result.p99_ns << std::setw(12) << result.max_ns << std::endl;
+  results.push_back(result);
+}
+
+void benchmarkComponentLookup(const BenchmarkOptions& options,
+                              size_t num_entities,
+                              std::vector<BenchmarkResult>& results) {
+  std::unordered_map<std::string, PositionComponent> positions;
+  std::vector<std::string> tags;
+  for (size_t i = 0; i < num_entities; ++i) {
+    tags.push_back("tile_" + std::to_string(i));
+    positions.emplace(tags.back(), PositionComponent{tags.back(), 0, 0});
+  }
+  size_t next{0};
+  runBenchmark(options,
+               "component/get_or_panic/" + std::to_string(num_entities), 1000,
+               [&] {
+                 doNotOptimize(getComponentOrPanic(positions, tags[next]).x);
+                 next = next + 1 == tags.size() ? 0 : next + 1;
+               },
+               results);
+}
+
+// Movers standing on a row of tiles each, so every tick resolves ground
+// collisions like the game does
+void benchmarkPhysics(const BenchmarkOptions& options, size_t num_movers,
+                      std::vector<BenchmarkResult>& results) {
+  std::unordered_map<std::string, MovementComponent> movements;
+  std::unordered_map<std::string, PositionComponent> positions;
+  std::unordered_map<std::string, CollisionComponent> collisions;
+  constexpr size_t kMoversPerRow{32};
+  for (size_t i = 0; i < num_movers; ++i) {
+    const float x = (i % kMoversPerRow) * kTileSize * 2;
+    const float y = (i / kMoversPerRow) * kTileSize * 3;
+    const std::string mover{"mover_" + std::to_string(i)};
+    movements.emplace(mover, MovementComponent{mover});
+    positions.emplace(mover, PositionComponent{mover, x, y});
+    collisions.emplace(mover,
+                       CollisionComponent{mover, kTileSize, kTileSize});
+    const std::string ground{"ground_" + std::to_string(i)};
+    positions.emplace(ground, PositionComponent{ground, x, y + kTileSize});
+    collisions.emplace(ground,
+                       CollisionComponent{ground, kTileSize * 2, kTileSize});
+  }
+  PhysicsSystem physics;
+  physics.init(movements, positions, collisions);
+  runBenchmark(options, "physics/update/" + std::to_string(num_movers), 1,
+               [&] { physics.update(kFixedTimestep); }, results);
+}
+
+// Parsing only, the file is read into memory first
+void benchmarkLevelLoad(const BenchmarkOptions& options,
+                        std::vector<BenchmarkResult>& results) {
+  std::ifstream file{kLevelPath};
+  if (!file.is_open()) {
+    std::cerr << "Skipping level load, no " << kLevelPath << std::endl;
+    return;
+  }
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  const std::string json{contents.str()};
+  runBenchmark(options, "level/from_json", 1,
+               [&] {
+                 std::istringstream input{json};
+                 LevelData level;
+                 doNotOptimize(LevelData::fromJson(input, level));
+               },
+               results);
+}
+
+// A screen sized view into a full map, and the whole of a smaller one
+void benchmarkTileMapDraw(const BenchmarkOptions& options,
+                          AssetManager& assets,
+                          std::vector<BenchmarkResult>& results) {
+  const std::vector<TextureEntry>& textures = assets.getTextures();
+  if (textures.empty()) {
+    std::cerr << "Skipping tile map draw, no textures" << std::endl;
+    return;
+  }
+  RenderCommandList commands;
+  for (const size_t size : {size_t{64}, size_t{1024}}) {
+    TileMap tiles{size, size, assets};
+    for (size_t y = 0; y < size; ++y) {
+      for (size_t x = 0; x < size; ++x) {
+        tiles.addTile(x, y,
+                      static_cast<TextureHandle>((x + y) % textures.size()));
+      }
+    }
+    const Rectangle view =
+        size > 64 ? Rectangle{size * kTileSize / 2, size * kTileSize / 2,
+                              kScreenWidth, kScreenHeight}
+                  : Rectangle{0, 0, size * kTileSize, size * kTileSize};
+    runBenchmark(options,
+                 "tilemap/draw/" + std::to_string(size) +
+                     (size > 64 ? "_view" : "_full"),
+                 1,
+                 [&] {
+                   commands.clear();
+                   tiles.draw(commands, view);
+                   doNotOptimize(commands.size());
+                 },
+                 results);
+  }
+}
+
+void benchmarkAssetLookup(const BenchmarkOptions& options,
+                          AssetManager& assets,
+                          std::vector<BenchmarkResult>& results) {
+  const std::vector<TextureEntry>& textures = assets.getTextures();
+  if (textures.empty()) {
+    std::cerr << "Skipping asset lookup, no textures" << std::endl;
+    return;
+  }
+  std::vector<std::string> names;
+  for (const auto& texture : textures) {
+    names.push_back(texture.name);
+  }
+  size_t next{0};
+  runBenchmark(options, "asset/get_handle", 1000,
+               [&] {
+                 doNotOptimize(assets.getHandle(names[next]));
+                 next = next + 1 == names.size() ? 0 : next + 1;
+               },
+               results);
+  // Everything is loaded by now so this is the per frame hit path
+  next = 0;
+  runBenchmark(options, "asset/get_texture", 1000,
+               [&] {
+                 doNotOptimize(assets.getTexture(next).width);
+                 next = next + 1 == textures.size() ? 0 : next + 1;
+               },
+               results);
+}
+
+bool writeBenchmarkJson(const std::string& path,
+                        const std::vector<BenchmarkResult>& results) {
+  nlohmann::json benchmarks = nlohmann::json::array();
+  for (const auto& result : results) {
+    benchmarks.push_back({{"name", result.name},
+                          {"iterations", result.iterations},
+                          {"samples", result.samples},
+                          {"mean_ns", result.mean_ns},
+                          {"p50_ns", result.p50_ns},
+                          {"p95_ns", result.p95_ns},
+                          {"p99_ns", result.p99_ns},
+                          {"max_ns", result.max_ns}});
+  }
+#ifdef NDEBUG
+  constexpr bool kDebugBuild{false};
+#else
+  constexpr bool kDebugBuild{true};
+#endif
+  std::ofstream file{path};
+  file << nlohmann::json{{"debug_build", kDebugBuild},
+                         {"benchmarks", benchmarks}}
+              .dump(2)
+       << '\n';
+  return file.good();
+}
+
+int main(int argc, char** argv) {
+  BenchmarkOptions options;
+  std::string json_path;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg{argv[i]};
+    const bool has_value = i + 1 < argc;
+    if (arg == "--json" && has_value) {
+      json_path = argv[++i];
+    } else if (arg == "--filter" && has_value) {
+      options.filter = argv[++i];
+    } else if (arg == "--min-time-ms" && has_value) {
+      options.min_time =
+          std::chrono::milliseconds{std::strtoull(argv[++i], nullptr, 10)};
+    } else {
+      std::cerr << "Usage: " << argv[0]
+                << " [--json FILE] [--filter TEXT] [--min-time-ms N]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // Registered like the game does, headless so no window is needed
+  AssetManager assets{true};
+  AssetManifest manifest;
+  if (manifest.loadFromFile(kManifestPath)) {
+    assets.registerManifest(manifest);
+  }
+
+  std::cout << std::left << std::setw(36) << "benchmark (ns/iteration)"
+            << std::right << std::setw(12) << "mean" << std::setw(12) << "p50"
+            << std::setw(12) << "p95" << std::setw(12) << "p99"
+            << std::setw(12) << "max" << std::endl;
+  std::vector<BenchmarkResult> results;
+  for (const size_t num_entities : {size_t{100}, size_t{10000}}) {
+    benchmarkComponentLookup(options, num_entities, results);
+  }
+  for (const size_t num_movers : {size_t{10}, size_t{100}, size_t{1000}}) {
+    benchmarkPhysics(options, num_movers, results);
+  }
+  benchmarkLevelLoad(options, results);
+  benchmarkTileMapDraw(options, assets, results);
+  benchmarkAssetLookup(options, assets, results);
+
+  if (!json_path.empty() && !writeBenchmarkJson(json_path, results)) {
+    std::cerr << "Failed to write " << json_path << std::endl;
+    return 1;
+  }
+  return 0;
+}
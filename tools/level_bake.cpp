@@ -0,0 +1,73 @@
+// Bakes a level into the ready to load form LevelScene prefers: merged
+// colliders, per chunk draw lists and texture handles resolved against the
+// asset manifest. Rebake whenever the level or the manifest changes, the
+// game falls back to the level itself if the baked file is stale.
+//
+// Usage: Platformer2dLevelBake <manifest.json> <level.json|.p2dl> <output>
+//
+// Run from the repository root (or build the level_bake target, which
+// bakes every level in assets/levels/).
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "level/baked_level.h"
+#include "level/level_file.h"
+#include "managers/asset_manager.h"
+#include "managers/asset_manifest.h"
+
+using namespace platformer2d;
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " <manifest.json> <level.json|.p2dl> <output>" << std::endl;
+    return 1;
+  }
+  const std::string manifest_path{argv[1]};
+  const std::string level_path{argv[2]};
+  const std::string output_path{argv[3]};
+
+  AssetManifest manifest;
+  if (!manifest.loadFromFile(manifest_path)) {
+    std::cerr << "Failed to read " << manifest_path << std::endl;
+    return 1;
+  }
+  // Registered exactly as the game does so the handles line up
+  AssetManager assets{true};
+  assets.registerManifest(manifest);
+
+  LevelData level;
+  if (level_path.ends_with(".json")) {
+    std::ifstream input{level_path};
+    if (!LevelData::fromJson(input, level)) {
+      std::cerr << "Failed to read level " << level_path << std::endl;
+      return 1;
+    }
+  } else {
+    LevelFile input;
+    if (!input.open(level_path)) {
+      std::cerr << "Failed to read level " << level_path << std::endl;
+      return 1;
+    }
+    level = input.toData();
+  }
+
+  if (!bakeLevel(level, assets, output_path)) {
+    std::cerr << "Failed to bake " << output_path << std::endl;
+    return 1;
+  }
+  BakedLevel baked;
+  if (!baked.open(output_path)) {
+    std::cerr << "Baked level " << output_path << " does not read back"
+              << std::endl;
+    return 1;
+  }
+  std::cout << "Baked " << level.width << "x" << level.height << " level to "
+            << output_path << ": " << baked.getSprites().size()
+            << " sprites in " << baked.getChunks().size() << " chunks, "
+            << baked.getColliders().size() << " colliders, "
+            << baked.getMovingTiles().size() << " moving tiles" << std::endl;
+  return 0;
+}
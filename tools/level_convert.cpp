@@ -0,0 +1,53 @@
+// Converts levels between the json and binary formats. The direction is
+// picked from the input's extension.
+//
+// Usage: Platformer2dLevelConvert <input.json> <output.p2dl>
+//        Platformer2dLevelConvert <input.p2dl> <output.json>
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "level/level_file.h"
+#include "nlohmann/json.hpp"
+
+using namespace platformer2d;
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <input> <output>" << std::endl;
+    return 1;
+  }
+  const std::string input_path{argv[1]};
+  const std::string output_path{argv[2]};
+
+  LevelData level;
+  if (input_path.ends_with(".json")) {
+    std::ifstream input{input_path};
+    if (!LevelData::fromJson(input, level)) {
+      std::cerr << "Failed to read level " << input_path << std::endl;
+      return 1;
+    }
+    if (!level.saveBinary(output_path)) {
+      std::cerr << "Failed to write " << output_path << std::endl;
+      return 1;
+    }
+  } else {
+    LevelFile input;
+    if (!input.open(input_path)) {
+      std::cerr << "Failed to read level " << input_path << std::endl;
+      return 1;
+    }
+    level = input.toData();
+    std::ofstream output{output_path};
+    output << level.toJson();
+    if (!output.good()) {
+      std::cerr << "Failed to write " << output_path << std::endl;
+      return 1;
+    }
+  }
+  std::cout << "Converted " << level.width << "x" << level.height
+            << " level with " << level.palette.size() << " textures to "
+            << output_path << std::endl;
+  return 0;
+}